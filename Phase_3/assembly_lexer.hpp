@@ -0,0 +1,92 @@
+#ifndef ASSEMBLY_LEXER_HPP
+#define ASSEMBLY_LEXER_HPP
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <string_view>
+
+// Allocation-free tokenizer shared by the program loader and InstructionParser.
+// Every token is a view into the caller's source text, so the text must outlive it.
+class AssemblyLexer {
+public:
+    static constexpr size_t MAX_OPERANDS = 8;
+    using OperandList = std::array<std::string_view, MAX_OPERANDS>;
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    static std::string_view trimLeft(std::string_view s) {
+        size_t i = 0;
+        while (i < s.size() && isSpace(s[i])) i++;
+        return s.substr(i);
+    }
+
+    static std::string_view trim(std::string_view s) {
+        s = trimLeft(s);
+        size_t n = s.size();
+        while (n > 0 && isSpace(s[n - 1])) n--;
+        return s.substr(0, n);
+    }
+
+    static std::string_view stripComment(std::string_view s) {
+        size_t commentPos = s.find('#');
+        return commentPos == std::string_view::npos ? s : s.substr(0, commentPos);
+    }
+
+    // Pops the next line (without its '\n') off the front of text
+    static std::string_view nextLine(std::string_view &text) {
+        size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text = (end == std::string_view::npos) ? std::string_view() : text.substr(end + 1);
+        return line;
+    }
+
+    // Pops the next whitespace-delimited word off the front of text
+    static std::string_view nextWord(std::string_view &text) {
+        text = trimLeft(text);
+        size_t end = 0;
+        while (end < text.size() && !isSpace(text[end])) end++;
+        std::string_view word = text.substr(0, end);
+        text = text.substr(end);
+        return word;
+    }
+
+    // Splits "a, b ,c" on commas, trimming each operand and dropping empty ones.
+    // Anything after a '#' is ignored. Returns the number of operands stored.
+    static size_t splitOperands(std::string_view rest, OperandList &out) {
+        rest = stripComment(rest);
+        size_t count = 0;
+        while (true) {
+            size_t comma = rest.find(',');
+            std::string_view operand = trim(rest.substr(0, comma));
+            if (!operand.empty() && count < MAX_OPERANDS) {
+                out[count++] = operand;
+            }
+            if (comma == std::string_view::npos) break;
+            rest = rest.substr(comma + 1);
+        }
+        return count;
+    }
+
+    // Parses a leading decimal integer (optional sign) the way std::stoi does,
+    // ignoring any trailing characters. Returns false instead of throwing.
+    static bool parseInt(std::string_view s, int &value) {
+        s = trimLeft(s);
+        if (!s.empty() && s[0] == '+') s.remove_prefix(1);
+        auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+        return ec == std::errc() && ptr != s.data();
+    }
+
+    // "x12" -> 12, anything else -> -1
+    static int parseRegister(std::string_view reg) {
+        int index = -1;
+        if (reg.size() >= 2 && reg[0] == 'x' && parseInt(reg.substr(1), index)) {
+            return index;
+        }
+        return -1;
+    }
+};
+
+#endif // ASSEMBLY_LEXER_HPP
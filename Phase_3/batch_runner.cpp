@@ -0,0 +1,185 @@
+#include "batch_runner.hpp"
+#include "sim_log.hpp"
+#include "work_stealing_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    double missRate(const MemoryHierarchy::CacheStats &stats) {
+        return stats.accesses > 0 ? static_cast<double>(stats.misses) / stats.accesses : 0.0;
+    }
+
+    double ipc(const BatchResult &result) {
+        return result.cycles > 0 ? static_cast<double>(result.instructions) / result.cycles : 0.0;
+    }
+}
+
+BatchRunner::BatchRunner(int threads)
+    : threads(threads > 0 ? threads : WorkStealingPool::hostThreads()) {
+}
+
+std::vector<BatchJob> BatchRunner::loadJobs(const std::string &filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open job list: " + filename);
+    }
+
+    std::vector<BatchJob> jobs;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string word;
+        BatchJob job;
+        bool any = false;
+        try {
+            while (words >> word) {
+                any = true;
+                size_t equals = word.find('=');
+                if (equals == std::string::npos) {
+                    throw std::invalid_argument("expected key=value, got '" + word + "'");
+                }
+                std::string key = word.substr(0, equals);
+                std::string value = word.substr(equals + 1);
+                if (key == "name") {
+                    job.name = value;
+                } else if (key == "program") {
+                    job.programFile = value;
+                } else if (key == "cache") {
+                    job.cacheConfigFile = value;
+                } else if (key == "cores") {
+                    job.numCores = std::stoi(value);
+                } else if (key == "forwarding") {
+                    job.forwarding = value == "y" || value == "Y";
+                } else if (key == "trace") {
+                    job.tracePrefix = value;
+                } else if (key == "add" || key == "addi" || key == "sub" || key == "slt" || key == "mul") {
+                    job.latencies.emplace_back(key, std::stoi(value));
+                } else {
+                    throw std::invalid_argument("unknown key '" + key + "'");
+                }
+            }
+        } catch (const std::exception &e) {
+            throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": " + e.what());
+        }
+        if (!any) {
+            continue;
+        }
+        if (job.programFile.empty()) {
+            throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": no program");
+        }
+        if (job.name.empty()) {
+            job.name = "job" + std::to_string(jobs.size());
+        }
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+BatchResult BatchRunner::runJob(const BatchJob &job) {
+    BatchResult result;
+    result.name = job.name;
+
+    // Trace messages from this thread go to the job, not interleaved on stdout
+    std::ostringstream log;
+    SimLog::setStream(&log);
+    auto start = std::chrono::steady_clock::now();
+    try {
+        // MemoryHierarchy falls back to defaults for a missing file; a batch
+        // would rather know
+        if (!job.cacheConfig && !job.cacheConfigFile.empty() &&
+            !std::ifstream(job.cacheConfigFile).is_open()) {
+            throw std::runtime_error("Could not open cache configuration: " + job.cacheConfigFile);
+        }
+        PipelinedSimulator simulator(job.numCores, job.forwarding);
+        simulator.setForwardingEnabled(job.forwarding);
+        simulator.setTracePrefix(job.tracePrefix);
+        for (const auto &[instruction, latency]: job.latencies) {
+            simulator.setInstructionLatency(instruction, latency);
+        }
+        if (job.cacheConfig) {
+            simulator.setCacheConfig(*job.cacheConfig);
+        } else if (!job.cacheConfigFile.empty()) {
+            simulator.loadCacheConfig(job.cacheConfigFile);
+        }
+        simulator.loadProgramFromFile(job.programFile);
+        simulator.simulate();
+
+        std::vector<int> cycles = simulator.getCycleCounts();
+        result.cycles = *std::max_element(cycles.begin(), cycles.end());
+        result.instructions = simulator.getTotalInstructions();
+        result.stalls = simulator.getTotalStalls();
+        result.memoryStalls = simulator.getTotalMemoryStalls();
+        result.l1i = simulator.cacheTotals(MemoryHierarchy::CacheType::L1I);
+        result.l1d = simulator.cacheTotals(MemoryHierarchy::CacheType::L1D);
+        result.l2 = simulator.cacheTotals(MemoryHierarchy::CacheType::L2);
+    } catch (const std::exception &e) {
+        result.error = e.what();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    SimLog::setStream(nullptr);
+    result.log = log.str();
+    return result;
+}
+
+std::vector<BatchResult> BatchRunner::run(const std::vector<BatchJob> &jobs) const {
+    std::vector<BatchResult> results(jobs.size());
+    WorkStealingPool pool(threads);
+    pool.run(jobs.size(), [&](size_t i) { results[i] = runJob(jobs[i]); });
+    return results;
+}
+
+void BatchRunner::printTable(const std::vector<BatchResult> &results, std::ostream &out) {
+    size_t nameWidth = 4;
+    for (const auto &result: results) {
+        nameWidth = std::max(nameWidth, result.name.size());
+    }
+    out << std::left << std::setw(static_cast<int>(nameWidth)) << "Job" << std::right
+        << std::setw(12) << "Cycles" << std::setw(14) << "Instructions" << std::setw(8) << "IPC"
+        << std::setw(12) << "Stalls" << std::setw(12) << "Mem stalls"
+        << std::setw(9) << "L1I miss" << std::setw(9) << "L1D miss" << std::setw(9) << "L2 miss"
+        << std::setw(10) << "Wall s" << "\n";
+    out << std::fixed;
+    for (const auto &result: results) {
+        out << std::left << std::setw(static_cast<int>(nameWidth)) << result.name << std::right;
+        if (!result.error.empty()) {
+            out << "  failed: " << result.error << "\n";
+            continue;
+        }
+        out << std::setw(12) << result.cycles << std::setw(14) << result.instructions
+            << std::setw(8) << std::setprecision(2) << ipc(result)
+            << std::setw(12) << result.stalls << std::setw(12) << result.memoryStalls
+            << std::setw(8) << missRate(result.l1i) * 100.0 << "%"
+            << std::setw(8) << missRate(result.l1d) * 100.0 << "%"
+            << std::setw(8) << missRate(result.l2) * 100.0 << "%"
+            << std::setw(10) << std::setprecision(3) << result.seconds << "\n";
+    }
+    out.unsetf(std::ios::floatfield);
+    out << std::setprecision(6);
+}
+
+void BatchRunner::writeCsv(const std::vector<BatchResult> &results, std::ostream &out) {
+    out << "job,status,cycles,instructions,ipc,stalls,memory_stalls,"
+           "l1i_accesses,l1i_misses,l1d_accesses,l1d_misses,l2_accesses,l2_misses,seconds\n";
+    for (const auto &result: results) {
+        out << result.name << ",";
+        if (!result.error.empty()) {
+            std::string error = result.error;
+            std::replace(error.begin(), error.end(), ',', ';');
+            out << "failed: " << error << ",,,,,,,,,,,,\n";
+            continue;
+        }
+        out << "ok," << result.cycles << "," << result.instructions << "," << ipc(result) << ","
+            << result.stalls << "," << result.memoryStalls << ","
+            << result.l1i.accesses << "," << result.l1i.misses << ","
+            << result.l1d.accesses << "," << result.l1d.misses << ","
+            << result.l2.accesses << "," << result.l2.misses << "," << result.seconds << "\n";
+    }
+}
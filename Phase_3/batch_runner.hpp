@@ -0,0 +1,67 @@
+#ifndef BATCH_RUNNER_HPP
+#define BATCH_RUNNER_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "pipelined_simulator.hpp"
+
+// One independent simulation: a program under one configuration, run from the
+// start to the end in a simulator of its own
+struct BatchJob {
+    std::string name;
+    std::string programFile;
+    std::string cacheConfigFile;        // empty: the default configuration
+    std::optional<CacheConfig> cacheConfig;    // used instead of the file when set
+    int numCores = 4;
+    bool forwarding = true;
+    std::vector<std::pair<std::string, int>> latencies;   // instruction, cycles
+    std::string tracePrefix;            // empty: no pipeline traces
+};
+
+struct BatchResult {
+    std::string name;
+    std::string error;                  // empty when the job ran to the end
+    int cycles = 0;                     // slowest core
+    uint64_t instructions = 0;
+    uint64_t stalls = 0;
+    uint64_t memoryStalls = 0;
+    MemoryHierarchy::CacheStats l1i{}, l1d{}, l2{};
+    double seconds = 0.0;
+    std::string log;                    // the job's trace messages, if any were enabled
+};
+
+// Runs many simulations concurrently, one PipelinedSimulator per job, on a
+// work-stealing pool. Jobs share nothing: each has its own memory hierarchy,
+// its own trace files (if any) and its trace messages collected separately.
+// Results come back in job order whatever order the jobs finished in.
+class BatchRunner {
+public:
+    // 0 threads: one per host CPU
+    explicit BatchRunner(int threads = 0);
+
+    // Job list: one job per line as space-separated key=value pairs, '#'
+    // starts a comment. Keys: name, program (required), cache, cores,
+    // forwarding (y/n), trace (file prefix), and a latency per instruction
+    // (add, addi, sub, slt, mul). Throws std::runtime_error naming the line.
+    static std::vector<BatchJob> loadJobs(const std::string& filename);
+
+    // A job that fails (bad file, stuck run) reports its error in the result;
+    // the rest of the batch carries on
+    std::vector<BatchResult> run(const std::vector<BatchJob>& jobs) const;
+
+    static void printTable(const std::vector<BatchResult>& results, std::ostream& out);
+    static void writeCsv(const std::vector<BatchResult>& results, std::ostream& out);
+
+    int getThreadCount() const { return threads; }
+
+private:
+    int threads;
+
+    static BatchResult runJob(const BatchJob& job);
+};
+
+#endif // BATCH_RUNNER_HPP
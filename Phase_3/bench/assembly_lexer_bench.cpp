@@ -0,0 +1,110 @@
+// Program-load microbenchmark for AssemblyLexer / InstructionParser: times
+// PipelinedSimulator::loadProgram (lexing, label resolution and pre-decode)
+// on a generated program.
+//
+//   assembly_lexer_bench [lines=100000] [loads=3] [--emit <file>]
+//
+// --emit writes the generated program to <file> instead of timing it.
+#include "pipelined_simulator.hpp"
+#include "sim_log.hpp"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// A .data block of 16 words followed by `lines` text lines: a random mix of
+// R-type, addi, lw/sw, branches, jal and la, with a label every 16 lines for
+// the branches and jumps to target. The seed is fixed, so every run parses
+// the same text.
+std::string generateProgram(int lines, unsigned seed = 1) {
+    std::mt19937 rng(seed);
+    // x31 is left out: "beq x31, <core>, label" is the compute-unit dispatch form
+    auto reg = [&]() { return "x" + std::to_string(1 + rng() % 30); };
+    auto imm = [&]() { return std::to_string(static_cast<int>(rng() % 2048) - 1024); };
+    const int labels = (lines + 15) / 16;
+    auto label = [&]() { return "L" + std::to_string(rng() % labels); };
+    static const char *rType[] = {"add", "sub", "slt", "mul"};
+    static const char *branches[] = {"beq", "bne", "blt", "bge"};
+
+    std::ostringstream out;
+    out << ".data\n";
+    for (int i = 0; i < 16; i++) {
+        out << "d" << i << ":  .word " << i << ", " << i * 3 << "    # data\n";
+    }
+    out << "\n.text\n";
+    for (int i = 0; i < lines; i++) {
+        if (i % 16 == 0) {
+            out << "L" << i / 16 << ":\n";
+        }
+        switch (rng() % 8) {
+            case 0:
+            case 1:
+                out << "    " << rType[rng() % 4] << " " << reg() << ", " << reg() << ", " << reg() << "\n";
+                break;
+            case 2:
+            case 3:
+                out << "    addi  " << reg() << ", " << reg() << ", " << imm() << "   # immediate\n";
+                break;
+            case 4:
+                out << "    lw " << reg() << ", " << (rng() % 16) * 4 << "(" << reg() << ")\n";
+                break;
+            case 5:
+                out << "    sw " << reg() << ", " << (rng() % 16) * 4 << "(" << reg() << ")\n";
+                break;
+            case 6:
+                if (rng() % 2) {
+                    out << "    " << branches[rng() % 4] << " " << reg() << ", " << reg() << ", " << label() << "\n";
+                } else {
+                    out << "    jal " << reg() << ", " << label() << "\n";
+                }
+                break;
+            default:
+                out << "    la " << reg() << ", d" << rng() % 16 << "\n";
+                break;
+        }
+    }
+    out << "    halt\n";
+    return out.str();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int lines = 100000;
+    int loads = 3;
+    std::string emitPath;
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--emit" && i + 1 < argc) {
+            emitPath = argv[++i];
+        } else if (positional++ == 0) {
+            lines = std::stoi(arg);
+        } else {
+            loads = std::stoi(arg);
+        }
+    }
+
+    std::string program = generateProgram(lines);
+    if (!emitPath.empty()) {
+        std::ofstream(emitPath) << program;
+        std::cout << "Wrote " << lines << " lines to " << emitPath << "\n";
+        return 0;
+    }
+
+    SimLog::setLevel(LogLevel::OFF);
+    double totalMs = 0.0;
+    for (int i = 0; i < loads; i++) {
+        PipelinedSimulator simulator(4);
+        auto start = std::chrono::steady_clock::now();
+        simulator.loadProgram(program);
+        totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::cout << lines << " lines, " << loads << " loads: " << totalMs / loads << " ms per load ("
+              << lines / (totalMs / loads) / 1000.0 << " M lines/s)\n";
+    return 0;
+}
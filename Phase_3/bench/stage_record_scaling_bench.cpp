@@ -0,0 +1,70 @@
+// Simulation speed against run length, for the per-instruction stage
+// recording (PipelinedCore::recordStageForInstruction / openTraceRows). Cost
+// per cycle must not grow with the cycles already simulated, so cycles/s
+// should stay flat from 10k to 10M cycles.
+//
+//   stage_record_scaling_bench [cycles...] [--trace <prefix>]
+//
+// Default lengths: 10k, 100k, 1M and 10M cycles. The workload is a 4-core
+// counting loop (addi/addi/bne, 4 cycles per iteration). Stages are recorded
+// either way; --trace also streams them to <prefix>N.trace (about 48 bytes
+// per cycle per core).
+#include "pipelined_simulator.hpp"
+#include "sim_log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string countingLoop(long iterations) {
+    return ".text\n"
+           "    addi x1, x0, " + std::to_string(iterations) + "\n"
+           "loop:\n"
+           "    addi x2, x2, 1\n"
+           "    addi x1, x1, -1\n"
+           "    bne x1, x0, loop\n"
+           "    halt\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::vector<long> lengths;
+    std::string tracePrefix;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--trace" && i + 1 < argc) {
+            tracePrefix = argv[++i];
+        } else {
+            lengths.push_back(std::stol(arg));
+        }
+    }
+    if (lengths.empty()) {
+        lengths = {10000, 100000, 1000000, 10000000};
+    }
+
+    SimLog::setLevel(LogLevel::OFF);
+    double slowest = 0.0, fastest = 0.0;
+    for (long length: lengths) {
+        PipelinedSimulator simulator(4);
+        simulator.setTracePrefix(tracePrefix);
+        simulator.loadProgram(countingLoop(length / 4));
+
+        auto start = std::chrono::steady_clock::now();
+        simulator.simulate();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        simulator.finishTraces();
+
+        auto cycles = simulator.getCycleCounts();
+        int maxCycles = *std::max_element(cycles.begin(), cycles.end());
+        double rate = maxCycles / seconds;
+        slowest = slowest == 0.0 ? rate : std::min(slowest, rate);
+        fastest = std::max(fastest, rate);
+        std::cout << maxCycles << " cycles: " << seconds << " s, " << rate / 1000.0 << "k cycles/s\n";
+    }
+    std::cout << "fastest / slowest: " << fastest / slowest << "\n";
+    return 0;
+}
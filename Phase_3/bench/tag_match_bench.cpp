@@ -0,0 +1,132 @@
+// Tag lookup microbenchmark for findMatchingWay (tag_match.hpp) on 8- and
+// 16-way sets: the scalar loop against the SSE2 and AVX2 compares, then
+// L2Cache::contains and read hits with those associativities.
+//
+//   tag_match_bench [rounds=20]
+//
+// Only the widths compiled in are timed; the tag_match_bench_avx2 target is
+// the same source built with -mavx2 and times the raw lookups only, since the
+// simulator library it would otherwise link is built without AVX2.
+#include "tag_match.hpp"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#ifndef TAG_MATCH_BENCH_RAW_ONLY
+#include "cache_system.hpp"
+#include "sim_log.hpp"
+#endif
+
+namespace {
+
+using Lookup = int (*)(const uint32_t*, const uint8_t*, int, uint32_t, int);
+
+// 4096 sets of `ways` random tags, all valid, and 1M probes: half hit a way
+// chosen uniformly, half miss
+struct SetArray {
+    int ways;
+    std::vector<uint32_t> tags;
+    std::vector<uint8_t> valid;
+    std::vector<uint32_t> probeSets;
+    std::vector<uint32_t> probeTags;
+
+    explicit SetArray(int ways) : ways(ways) {
+        const int sets = 4096;
+        std::mt19937 rng(1);
+        tags.resize(sets * ways);
+        valid.assign(sets * ways, 1);
+        for (uint32_t &tag: tags) {
+            tag = rng() | 1;
+        }
+        for (int i = 0; i < (1 << 20); i++) {
+            uint32_t set = rng() % sets;
+            probeSets.push_back(set);
+            probeTags.push_back(i % 2 ? tags[set * ways + rng() % ways] : rng() & ~1u);
+        }
+    }
+};
+
+void timeLookup(const char *name, Lookup lookup, const SetArray &array, int rounds) {
+    int64_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < array.probeSets.size(); i++) {
+            size_t first = array.probeSets[i] * array.ways;
+            found += lookup(&array.tags[first], &array.valid[first], array.ways, array.probeTags[i], 0);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  " << name << ": " << rounds * array.probeSets.size() / seconds / 1e6
+              << " M lookups/s (checksum " << found << ")\n";
+}
+
+#ifndef TAG_MATCH_BENCH_RAW_ONLY
+// A 256 KiB L2 with 64-byte blocks, as in cache_config.txt, filled once
+void timeL2(int ways, int rounds) {
+    const uint32_t size = 262144;
+    L2Cache l2(size, 64, ways, 10, ReplacementPolicy::FIFO);
+    l2.setNextLevelCache(std::make_unique<MemorySystem>(std::make_shared<MainMemory>(4096, 100)));
+    for (uint32_t address = 0; address < size; address += 64) {
+        l2.read(address, nullptr, 4);
+    }
+
+    std::mt19937 rng(1);
+    std::vector<uint32_t> mixed(1 << 20), hits(1 << 20);
+    for (uint32_t &address: mixed) {
+        address = (rng() % (2 * size)) & ~3u;
+    }
+    for (uint32_t &address: hits) {
+        address = (rng() % size) & ~3u;
+    }
+
+    uint64_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (uint32_t address: mixed) {
+            found += l2.contains(address);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  L2Cache::contains: " << rounds * mixed.size() / seconds / 1e6 << " M lookups/s ("
+              << found << " hits)\n";
+
+    uint64_t missesBefore = l2.getMisses();
+    uint8_t buffer[4];
+    uint64_t latency = 0;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (uint32_t address: hits) {
+            latency += l2.read(address, buffer, 4);
+        }
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  L2Cache::read hits: " << rounds * hits.size() / seconds / 1e6 << " M reads/s (misses "
+              << l2.getMisses() - missesBefore << ", latency " << latency << ")\n";
+}
+#endif
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int rounds = argc > 1 ? std::stoi(argv[1]) : 20;
+#ifndef TAG_MATCH_BENCH_RAW_ONLY
+    SimLog::setLevel(LogLevel::OFF);
+#endif
+    for (int ways: {8, 16}) {
+        std::cout << ways << "-way:\n";
+        SetArray array(ways);
+        timeLookup("scalar", findMatchingWayScalar, array, rounds);
+#ifdef TAG_MATCH_SSE2
+        timeLookup("SSE2", findMatchingWaySse2, array, rounds);
+#endif
+#ifdef TAG_MATCH_AVX2
+        timeLookup("AVX2", findMatchingWayAvx2, array, rounds);
+#endif
+#ifndef TAG_MATCH_BENCH_RAW_ONLY
+        timeL2(ways, rounds);
+#endif
+    }
+    return 0;
+}
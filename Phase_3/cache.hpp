@@ -2,12 +2,15 @@
 #define CACHE_HPP
 
 #include <vector>
+#include <algorithm>
 #include <deque>
 #include <unordered_map>
 #include <cstdint>
 #include <string>
 #include <memory>
 #include <mutex>
+#include "checkpoint.hpp"
+#include "fast_divisor.hpp"
 
 // Forward declaration
 class CacheSystem;
@@ -17,27 +20,6 @@ enum class ReplacementPolicy {
     FIFO   // First In First Out
 };
 
-struct CacheBlock {
-    uint32_t tag = 0;
-    bool valid = false;
-    bool dirty = false;
-    std::vector<uint8_t> data;
-    int timestamp = 0;  // Used for LRU/FIFO
-    
-    CacheBlock(int blockSize) : data(blockSize, 0) {}
-};
-
-struct CacheSet {
-    std::vector<CacheBlock> blocks;
-    std::deque<int> fifoQueue;  // For FIFO replacement policy
-    
-    CacheSet(int associativity, int blockSize) {
-        for (int i = 0; i < associativity; i++) {
-            blocks.emplace_back(blockSize);
-        }
-    }
-};
-
 class Cache {
 protected:
     std::string name;
@@ -46,25 +28,48 @@ protected:
     int associativity;    // 1 = direct mapped, cacheSize/blockSize = fully associative
     int accessLatency;    // in cycles
     ReplacementPolicy policy;
+    bool tagOnly;
     
     int numSets;
-    int setIndexBits;
+    int setIndexBits;     // bits needed for a set index, rounded up
     int blockOffsetBits;
     int tagBits;
+    // A block number (address >> blockOffsetBits) maps to set
+    // blockNumber % numSets with tag blockNumber / numSets. Power-of-two set
+    // counts take a mask and a shift; others divide through setDivisor.
+    bool powerOfTwoSets;
+    FastDivisor setDivisor;
     
     uint64_t accesses = 0;
     uint64_t hits = 0;
     uint64_t misses = 0;
     
-    std::vector<CacheSet> sets;
+    // Line store, structure of arrays: way w of set s is entry
+    // s * associativity + w of every array, so a set's tags sit together for
+    // the vector compare in findBlockInSet. Line data lives in one arena,
+    // blockSize bytes per line in the same order; empty in tag-only mode.
+    std::vector<uint32_t> tags;
+    std::vector<uint8_t> validBits;
+    std::vector<uint8_t> dirtyBits;
+    std::vector<int> timestamps;              // Used for LRU
+    std::vector<std::deque<int>> fifoQueues;  // One per set, for FIFO
+    std::vector<uint8_t> dataArena;
 
     std::mutex cacheMutex;
     
     int globalTimestamp = 0;
 
+    // One block each, allocated once: a miss reads the incoming block into
+    // fillBuffer, and the read that precedes a writeback lands in
+    // writebackBuffer. Only used under cacheMutex; empty in tag-only mode.
+    std::vector<uint8_t> fillBuffer;
+    std::vector<uint8_t> writebackBuffer;
+
 public:
+    // tagOnly: keep no line data; reads and writes only cost time and update
+    // statistics, and nothing is moved to or from the next level
     Cache(const std::string& name, int cacheSize, int blockSize, int associativity, 
-          int accessLatency, ReplacementPolicy policy);
+          int accessLatency, ReplacementPolicy policy, bool tagOnly = false);
     
     virtual ~Cache() = default;
     
@@ -74,17 +79,23 @@ public:
     CacheSystem* getNextLevelCache() const {
              return nextLevelCache.get();
             }
-    virtual std::pair<int, std::vector<uint8_t>> read(uint32_t address, int size);
-    virtual int write(uint32_t address, const std::vector<uint8_t>& data);
+    // Copies size bytes at address into out and returns the latency. out (or
+    // data) may be null when only the access matters (write-allocate, tag-only
+    // mode). A hit copies straight out of the line and allocates nothing.
+    virtual int read(uint32_t address, uint8_t* out, int size);
+    virtual int write(uint32_t address, const uint8_t* data, int size);
+    // read/write with the geometry fixed by Geometry (a CacheGeometry) and
+    // next as the level below; Cache::read/write use CacheGeometry<> over
+    // nextLevelCache. Defined in cache_path.hpp.
+    template <class Geometry, class Next>
+    int readWith(uint32_t address, uint8_t* out, int size, Next& next);
+    template <class Geometry, class Next>
+    int writeWith(uint32_t address, const uint8_t* data, int size, Next& next);
+    // True when the block holding address is present; no statistics or LRU update
+    bool contains(uint32_t address) const;
     void invalidateAll() {
-        // For each set in the cache...
-        for (auto &cacheSet : sets) {
-            // For each block in that set...
-            for (auto &block : cacheSet.blocks) {
-                block.valid = false;
-                block.dirty = false;
-            }
-        }
+        std::fill(validBits.begin(), validBits.end(), 0);
+        std::fill(dirtyBits.begin(), dirtyBits.end(), 0);
     }
 
     void invalidateBlock(uint32_t address);
@@ -100,7 +111,18 @@ public:
     int getBlockSize() const { return blockSize; }
     int getAssociativity() const { return associativity; }
     int getAccessLatency() const { return accessLatency; }
+    ReplacementPolicy getPolicy() const { return policy; }
+    bool isTagOnly() const { return tagOnly; }
     void resetStatistics();
+
+    // Checkpoint support. loadState returns false and leaves the cache alone
+    // when the saved size, block size or associativity differ from this cache;
+    // latency and replacement policy may differ.
+    void saveState(CheckpointWriter& out) const;
+    bool loadState(CheckpointReader& in);
+    // Copies every valid dirty line over the matching bytes of a memory image.
+    // Tag-only lines hold no data: main memory is already current.
+    void overlayDirtyLines(std::vector<uint8_t>& image) const;
     
 protected:
     std::unique_ptr<CacheSystem> nextLevelCache;
@@ -108,16 +130,35 @@ protected:
     uint32_t getSetIndex(uint32_t address) const;
     uint32_t getBlockOffset(uint32_t address) const;
     uint32_t getAddress(uint32_t tag, uint32_t setIndex) const;
+
+    size_t lineIndex(uint32_t setIndex, int way) const {
+        return static_cast<size_t>(setIndex) * associativity + way;
+    }
+    // Null in tag-only mode
+    uint8_t* lineData(size_t line) { return tagOnly ? nullptr : dataArena.data() + line * blockSize; }
+    const uint8_t* lineData(size_t line) const { return tagOnly ? nullptr : dataArena.data() + line * blockSize; }
+    // Writes every valid dirty line to next and marks it clean
+    void writeBackDirtyLines(CacheSystem* next);
     
     int findBlockInSet(uint32_t tag, uint32_t setIndex) const;
-    int selectVictim(uint32_t setIndex);
-    
-    void updateReplacementInfo(uint32_t setIndex, int blockIndex);
-
 
+    void writeToNextLevel(uint32_t address, const uint8_t* data, int size);
 
-    std::vector<uint8_t> readFromNextLevel(uint32_t address);
-    void writeToNextLevel(uint32_t address, const std::vector<uint8_t>& data);
+    // The access algorithm behind read/write, also instantiated for fixed
+    // geometries by StaticCachePath. Defined in cache_path.hpp.
+    template <class Geometry> int lineBytes() const;
+    template <class Geometry> int offsetBits() const;
+    template <class Geometry> int ways() const;
+    template <class Geometry> ReplacementPolicy replacement() const;
+    template <class Geometry> uint32_t tagOf(uint32_t address) const;
+    template <class Geometry> uint32_t setOf(uint32_t address) const;
+    template <class Geometry> uint32_t addressOf(uint32_t tag, uint32_t setIndex) const;
+    template <class Geometry> int findWay(uint32_t tag, uint32_t setIndex) const;
+    template <class Geometry> int selectVictim(uint32_t setIndex);
+    // filled: the block was just (re)loaded, as opposed to hit
+    template <class Geometry> void updateReplacementInfo(uint32_t setIndex, int blockIndex, bool filled);
+    template <class Geometry, class Next>
+    void writeToNextLevel(uint32_t address, const uint8_t* data, int size, Next& next);
 };
 
 #endif // CACHE_HPP
\ No newline at end of file
@@ -0,0 +1,133 @@
+#ifndef CACHE_CONFIG_HPP
+#define CACHE_CONFIG_HPP
+
+#include <istream>
+#include <sstream>
+#include <string>
+#include "cache.hpp"
+
+// Parameters of the memory hierarchy, as read from a cache configuration file
+// (KEY=VALUE lines, see cache_config.txt). Defaults apply to missing keys.
+struct CacheConfig {
+    int l1iSize = 16 * 1024;
+    int l1dSize = 16 * 1024;
+    int l2Size = 256 * 1024;
+    int l1iBlockSize = 64;
+    int l1dBlockSize = 64;
+    int l2BlockSize = 64;
+    int l1iAssoc = 2;
+    int l1dAssoc = 4;
+    int l2Assoc = 8;
+    int l1iLatency = 1;
+    int l1dLatency = 1;
+    int l2Latency = 10;
+    int memLatency = 100;
+    int spmSize = 16 * 1024;     // same as L1D
+    int spmLatency = 1;
+    ReplacementPolicy l1iPolicy = ReplacementPolicy::LRU;
+    ReplacementPolicy l1dPolicy = ReplacementPolicy::LRU;
+    ReplacementPolicy l2Policy = ReplacementPolicy::LRU;
+    // CACHE_MODE=TAG_ONLY: caches keep tags, state and replacement order but
+    // no data; every value lives in main memory (see MemoryHierarchy)
+    bool tagOnly = false;
+
+    // Sets one parameter by its file key. Returns false for an unknown key or
+    // policy name; throws std::invalid_argument / std::out_of_range for a
+    // value that is not a number.
+    bool set(const std::string &key, const std::string &value) {
+        if (int *field = intField(*this, key)) {
+            *field = std::stoi(value);
+            return true;
+        }
+        if (ReplacementPolicy *field = policyField(*this, key)) {
+            if (value == "LRU") *field = ReplacementPolicy::LRU;
+            else if (value == "FIFO") *field = ReplacementPolicy::FIFO;
+            else return false;
+            return true;
+        }
+        if (key == "CACHE_MODE") {
+            if (value == "DATA") tagOnly = false;
+            else if (value == "TAG_ONLY") tagOnly = true;
+            else return false;
+            return true;
+        }
+        return false;
+    }
+
+    // Applies the KEY=VALUE lines of a configuration file on top of the
+    // current values; other lines and unknown keys are skipped. A bad number
+    // throws, leaving the keys before it applied.
+    void read(std::istream &in) {
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream iss(line);
+            std::string key;
+            std::string value;
+            if (std::getline(iss, key, '=') && std::getline(iss, value)) {
+                set(trim(key), trim(value));
+            }
+        }
+    }
+
+    // The whole configuration in file form; equal configurations give equal text
+    std::string toString() const {
+        std::ostringstream out;
+        for (const char *key: INT_KEYS) {
+            out << key << "=" << *intField(*this, key) << "\n";
+        }
+        for (const char *key: POLICY_KEYS) {
+            ReplacementPolicy policy = *policyField(*this, key);
+            out << key << "=" << (policy == ReplacementPolicy::FIFO ? "FIFO" : "LRU") << "\n";
+        }
+        out << "CACHE_MODE=" << (tagOnly ? "TAG_ONLY" : "DATA") << "\n";
+        return out.str();
+    }
+
+private:
+    static constexpr const char *INT_KEYS[] = {
+        "L1I_SIZE", "L1I_BLOCK_SIZE", "L1I_ASSOC", "L1I_LATENCY",
+        "L1D_SIZE", "L1D_BLOCK_SIZE", "L1D_ASSOC", "L1D_LATENCY",
+        "L2_SIZE", "L2_BLOCK_SIZE", "L2_ASSOC", "L2_LATENCY",
+        "SPM_SIZE", "SPM_LATENCY", "MEM_LATENCY"
+    };
+    static constexpr const char *POLICY_KEYS[] = {"L1I_POLICY", "L1D_POLICY", "L2_POLICY"};
+
+    // Config is CacheConfig or const CacheConfig
+    template <typename Config>
+    static auto intField(Config &config, const std::string &key) -> decltype(&config.l1iSize) {
+        if (key == "L1I_SIZE") return &config.l1iSize;
+        if (key == "L1D_SIZE") return &config.l1dSize;
+        if (key == "L2_SIZE") return &config.l2Size;
+        if (key == "L1I_BLOCK_SIZE") return &config.l1iBlockSize;
+        if (key == "L1D_BLOCK_SIZE") return &config.l1dBlockSize;
+        if (key == "L2_BLOCK_SIZE") return &config.l2BlockSize;
+        if (key == "L1I_ASSOC") return &config.l1iAssoc;
+        if (key == "L1D_ASSOC") return &config.l1dAssoc;
+        if (key == "L2_ASSOC") return &config.l2Assoc;
+        if (key == "L1I_LATENCY") return &config.l1iLatency;
+        if (key == "L1D_LATENCY") return &config.l1dLatency;
+        if (key == "L2_LATENCY") return &config.l2Latency;
+        if (key == "MEM_LATENCY") return &config.memLatency;
+        if (key == "SPM_SIZE") return &config.spmSize;
+        if (key == "SPM_LATENCY") return &config.spmLatency;
+        return nullptr;
+    }
+
+    template <typename Config>
+    static auto policyField(Config &config, const std::string &key) -> decltype(&config.l1iPolicy) {
+        if (key == "L1I_POLICY") return &config.l1iPolicy;
+        if (key == "L1D_POLICY") return &config.l1dPolicy;
+        if (key == "L2_POLICY") return &config.l2Policy;
+        return nullptr;
+    }
+
+    static std::string trim(const std::string &s) {
+        size_t first = s.find_first_not_of(" \t");
+        if (first == std::string::npos) {
+            return "";
+        }
+        return s.substr(first, s.find_last_not_of(" \t") - first + 1);
+    }
+};
+
+#endif // CACHE_CONFIG_HPP
@@ -0,0 +1,62 @@
+#include "cache_path.hpp"
+
+namespace {
+
+template <class... Geometries>
+struct GeometryList {};
+
+template <int BlockSize, int Ways, ReplacementPolicy Policy>
+using Fixed = CacheGeometry<BlockSize, Ways, static_cast<int>(Policy)>;
+
+// The geometries with a compiled path: 64-byte lines at the usual way counts
+// (cache_config.txt is 64 B, 2-way L1 / 8-way L2, LRU), plus the 4-byte
+// direct-mapped L1 of the small sample configurations
+#if CACHE_STATIC_PATHS
+using L1Geometries = GeometryList<
+    Fixed<64, 1, ReplacementPolicy::LRU>, Fixed<64, 2, ReplacementPolicy::LRU>,
+    Fixed<64, 4, ReplacementPolicy::LRU>, Fixed<64, 8, ReplacementPolicy::LRU>,
+    Fixed<64, 1, ReplacementPolicy::FIFO>, Fixed<64, 2, ReplacementPolicy::FIFO>,
+    Fixed<64, 4, ReplacementPolicy::FIFO>, Fixed<64, 8, ReplacementPolicy::FIFO>,
+    Fixed<4, 1, ReplacementPolicy::LRU>>;
+using L2Geometries = GeometryList<
+    Fixed<64, 8, ReplacementPolicy::LRU>, Fixed<64, 16, ReplacementPolicy::LRU>,
+    Fixed<64, 8, ReplacementPolicy::FIFO>, Fixed<64, 16, ReplacementPolicy::FIFO>>;
+#else
+using L1Geometries = GeometryList<>;
+using L2Geometries = GeometryList<>;
+#endif
+
+template <class Geometry>
+bool matches(const Cache& cache) {
+    return cache.getBlockSize() == Geometry::BLOCK_SIZE && cache.getAssociativity() == Geometry::WAYS
+           && static_cast<int>(cache.getPolicy()) == Geometry::POLICY;
+}
+
+template <class L1Geometry, bool WriteThrough, class... L2s>
+std::unique_ptr<CacheSystem> pickL2(Cache& l1, Cache& l2, MainMemory& memory, GeometryList<L2s...>) {
+    std::unique_ptr<CacheSystem> path;
+    ((path == nullptr && matches<L2s>(l2)
+          ? void(path = std::make_unique<StaticCachePath<L1Geometry, L2s, WriteThrough>>(l1, l2, memory))
+          : void()),
+     ...);
+    return path;
+}
+
+template <bool WriteThrough, class... L1s>
+std::unique_ptr<CacheSystem> pickL1(Cache& l1, Cache& l2, MainMemory& memory, GeometryList<L1s...>) {
+    std::unique_ptr<CacheSystem> path;
+    ((path == nullptr && matches<L1s>(l1)
+          ? void(path = pickL2<L1s, WriteThrough>(l1, l2, memory, L2Geometries{}))
+          : void()),
+     ...);
+    return path;
+}
+
+} // namespace
+
+std::unique_ptr<CacheSystem> makeStaticCachePath(Cache& l1, bool writeThrough, Cache& l2, MainMemory& memory) {
+    if (writeThrough) {
+        return pickL1<true>(l1, l2, memory, L1Geometries{});
+    }
+    return pickL1<false>(l1, l2, memory, L1Geometries{});
+}
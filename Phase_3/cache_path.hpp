@@ -0,0 +1,390 @@
+#ifndef CACHE_PATH_HPP
+#define CACHE_PATH_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include "cache.hpp"
+#include "cache_system.hpp"
+#include "sim_log.hpp"
+#include "tag_match.hpp"
+
+// Set to 0 to build without the pre-instantiated geometries; every access
+// then takes the dynamic path
+#ifndef CACHE_STATIC_PATHS
+#define CACHE_STATIC_PATHS 1
+#endif
+
+constexpr int log2Exact(int value) {
+    return value > 1 ? 1 + log2Exact(value / 2) : 0;
+}
+
+// Cache geometry known at compile time. A zero block size or way count, or a
+// negative policy, is read from the cache at run time instead, so
+// CacheGeometry<> is the dynamic path Cache::read/write take.
+template <int BlockSize = 0, int Ways = 0, int Policy = -1>
+struct CacheGeometry {
+    static_assert((BlockSize & (BlockSize - 1)) == 0, "Block size must be a power of two");
+    static constexpr int BLOCK_SIZE = BlockSize;
+    static constexpr int WAYS = Ways;
+    static constexpr int POLICY = Policy;
+    static constexpr int OFFSET_BITS = log2Exact(BlockSize);
+};
+
+// Levels a cache can sit on. Each has present/read/write; only the first is
+// reached through a virtual call.
+
+// The cache's own nextLevelCache; null when it has none
+struct VirtualNextLevel {
+    CacheSystem* next;
+    bool present() const { return next != nullptr; }
+    int read(uint32_t address, uint8_t* out, int size) { return next->read(address, out, size); }
+    int write(uint32_t address, const uint8_t* data, int size) { return next->write(address, data, size); }
+};
+
+struct MainMemoryLevel {
+    MainMemory* memory;
+    bool present() const { return true; }
+    int read(uint32_t address, uint8_t* out, int size) { return memory->read(address, out, size); }
+    int write(uint32_t address, const uint8_t* data, int size) { return memory->write(address, data, size); }
+};
+
+// A cache of fixed geometry in front of a statically known level
+template <class Geometry, class Next>
+struct CacheLevel {
+    Cache* cache;
+    Next next;
+    bool present() const { return true; }
+    int read(uint32_t address, uint8_t* out, int size) {
+        return cache->readWith<Geometry>(address, out, size, next);
+    }
+    int write(uint32_t address, const uint8_t* data, int size) {
+        return cache->writeWith<Geometry>(address, data, size, next);
+    }
+};
+
+// Geometry accessors: constants for a fixed geometry, fields otherwise
+
+template <class Geometry>
+int Cache::lineBytes() const {
+    return Geometry::BLOCK_SIZE ? Geometry::BLOCK_SIZE : blockSize;
+}
+
+template <class Geometry>
+int Cache::offsetBits() const {
+    return Geometry::BLOCK_SIZE ? Geometry::OFFSET_BITS : blockOffsetBits;
+}
+
+template <class Geometry>
+int Cache::ways() const {
+    return Geometry::WAYS ? Geometry::WAYS : associativity;
+}
+
+template <class Geometry>
+ReplacementPolicy Cache::replacement() const {
+    return Geometry::POLICY < 0 ? policy : static_cast<ReplacementPolicy>(Geometry::POLICY);
+}
+
+template <class Geometry>
+uint32_t Cache::tagOf(uint32_t address) const {
+    uint32_t blockNumber = address >> offsetBits<Geometry>();
+    return powerOfTwoSets ? blockNumber >> setIndexBits : setDivisor.quotient(blockNumber);
+}
+
+template <class Geometry>
+uint32_t Cache::setOf(uint32_t address) const {
+    uint32_t blockNumber = address >> offsetBits<Geometry>();
+    return powerOfTwoSets ? blockNumber & (numSets - 1) : setDivisor.remainder(blockNumber);
+}
+
+template <class Geometry>
+uint32_t Cache::addressOf(uint32_t tag, uint32_t setIndex) const {
+    return (tag * static_cast<uint32_t>(numSets) + setIndex) << offsetBits<Geometry>();
+}
+
+template <class Geometry>
+int Cache::findWay(uint32_t tag, uint32_t setIndex) const {
+    size_t first = static_cast<size_t>(setIndex) * ways<Geometry>();
+    return findMatchingWay(&tags[first], &validBits[first], ways<Geometry>(), tag);
+}
+
+template <class Geometry>
+int Cache::selectVictim(uint32_t setIndex) {
+    size_t first = static_cast<size_t>(setIndex) * ways<Geometry>();
+
+    // Look for invalid block first
+    for (int i = 0; i < ways<Geometry>(); i++) {
+        if (!validBits[first + i]) {
+            return i;
+        }
+    }
+
+    // Use the specified replacement policy
+    if (replacement<Geometry>() == ReplacementPolicy::LRU) {
+        // Find block with smallest timestamp (least recently used)
+        int lruIndex = 0;
+        int minTimestamp = timestamps[first];
+
+        for (int i = 1; i < ways<Geometry>(); i++) {
+            if (timestamps[first + i] < minTimestamp) {
+                minTimestamp = timestamps[first + i];
+                lruIndex = i;
+            }
+        }
+        return lruIndex;
+    } else {  // FIFO
+        // Every valid way was queued when it was filled; the oldest goes
+        const auto& fifoQueue = fifoQueues[setIndex];
+        return fifoQueue.empty() ? 0 : fifoQueue.front();
+    }
+}
+
+template <class Geometry>
+void Cache::updateReplacementInfo(uint32_t setIndex, int blockIndex, bool filled) {
+    if (replacement<Geometry>() == ReplacementPolicy::LRU) {
+        // Update timestamp for LRU
+        timestamps[static_cast<size_t>(setIndex) * ways<Geometry>() + blockIndex] = globalTimestamp++;
+    } else if (filled) {
+        // For FIFO, only update the queue when bringing in a new block; a
+        // refilled way leaves its old place in the queue
+        auto& fifoQueue = fifoQueues[setIndex];
+        fifoQueue.erase(std::remove(fifoQueue.begin(), fifoQueue.end(), blockIndex), fifoQueue.end());
+        fifoQueue.push_back(blockIndex);
+    }
+}
+
+template <class Geometry, class Next>
+int Cache::readWith(uint32_t address, uint8_t* out, int size, Next& next) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    const int lineSize = lineBytes<Geometry>();
+
+    // Calculate cache addressing
+    uint32_t tag = tagOf<Geometry>(address);
+    uint32_t setIndex = setOf<Geometry>(address);
+    uint32_t blockOffset = address & (lineSize - 1);
+
+    accesses++;
+
+    // Check if the block is in the cache
+    int blockIndex = findWay<Geometry>(tag, setIndex);
+    int latency = accessLatency;
+
+    if (blockIndex != -1) {
+        // Cache hit
+        hits++;
+        updateReplacementInfo<Geometry>(setIndex, blockIndex, false);
+    } else {
+        // Cache miss
+        misses++;
+
+        // Fetch the block from the next level cache
+        uint32_t blockAddress = address & ~static_cast<uint32_t>(lineSize - 1);
+
+        // Get data and latency from next level in one operation
+        int nextLevelLatency = 0;
+        if (next.present()) {
+            nextLevelLatency = next.read(blockAddress, tagOnly ? nullptr : fillBuffer.data(), lineSize);
+        } else {
+            // Handle the case where there's no next level (should never happen in your design)
+            std::fill(fillBuffer.begin(), fillBuffer.end(), 0);
+        }
+
+        // Select a victim block to replace
+        blockIndex = selectVictim<Geometry>(setIndex);
+        size_t line = static_cast<size_t>(setIndex) * ways<Geometry>() + blockIndex;
+
+        // Handle writeback if necessary
+        if (validBits[line] && dirtyBits[line]) {
+            uint32_t victimAddress = addressOf<Geometry>(tags[line], setIndex);
+            writeToNextLevel<Geometry>(victimAddress, tagOnly ? nullptr : lineData(line), lineSize, next);
+        }
+
+        // Update the cache block
+        tags[line] = tag;
+        validBits[line] = true;
+        dirtyBits[line] = false;
+        if (!tagOnly) {
+            std::memcpy(lineData(line), fillBuffer.data(), lineSize);
+        }
+
+        updateReplacementInfo<Geometry>(setIndex, blockIndex, true);
+
+        // Add next level latency only once
+        latency += nextLevelLatency;
+    }
+
+    // Extract the requested data
+    int inBlock = std::min(size, static_cast<int>(lineSize - blockOffset));
+    if (out && !tagOnly) {
+        size_t line = static_cast<size_t>(setIndex) * ways<Geometry>() + blockIndex;
+        std::memcpy(out, dataArena.data() + line * lineSize + blockOffset, inBlock);
+    }
+    if (inBlock < size) {
+        // Need to fetch another block for the rest of the data
+        // This is a simplification - in reality we would need multiple cache accesses
+        latency += readWith<Geometry>(address + inBlock, out ? out + inBlock : nullptr, size - inBlock, next);
+    }
+    return latency;
+}
+
+template <class Geometry, class Next>
+int Cache::writeWith(uint32_t address, const uint8_t* data, int size, Next& next) {
+    if (SIM_LOG_ENABLED(CACHE, TRACE)) {
+        SimLog::out() <<" write to addr 0x" << std::hex << address
+              << ", data = ";
+        for (int i = 0; data && i < size; i++) SimLog::out() << std::hex << int(data[i]) << " ";
+        SimLog::out() << std::dec << "\n";
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    const int lineSize = lineBytes<Geometry>();
+
+    // Calculate cache addressing
+    uint32_t tag = tagOf<Geometry>(address);
+    uint32_t setIndex = setOf<Geometry>(address);
+    uint32_t blockOffset = address & (lineSize - 1);
+
+    accesses++;
+
+    // Check if the block is in the cache
+    int blockIndex = findWay<Geometry>(tag, setIndex);
+    int latency = accessLatency;
+    bool filled = blockIndex == -1;
+
+    if (!filled) {
+        // Cache hit
+        hits++;
+        updateReplacementInfo<Geometry>(setIndex, blockIndex, false);
+    } else {
+        // Cache miss
+        misses++;
+
+        // For write miss, we have two options:
+        // 1. Write-allocate: fetch the block and then write to it (what we'll do)
+        // 2. Write-no-allocate: write directly to next level without fetching
+
+        // Fetch the block from the next level cache (write-allocate)
+        if (!next.present()) {
+            throw std::runtime_error("No next level cache or memory configured");
+        }
+        uint32_t blockAddress = address & ~static_cast<uint32_t>(lineSize - 1);
+        next.read(blockAddress, tagOnly ? nullptr : fillBuffer.data(), lineSize);
+
+        // Select a victim block to replace
+        blockIndex = selectVictim<Geometry>(setIndex);
+        size_t line = static_cast<size_t>(setIndex) * ways<Geometry>() + blockIndex;
+
+        // Handle writeback if necessary
+        if (validBits[line] && dirtyBits[line]) {
+            uint32_t victimAddress = addressOf<Geometry>(tags[line], setIndex);
+            writeToNextLevel<Geometry>(victimAddress, tagOnly ? nullptr : lineData(line), lineSize, next);
+        }
+
+        // Update the cache block
+        tags[line] = tag;
+        validBits[line] = true;
+        if (!tagOnly) {
+            std::memcpy(lineData(line), fillBuffer.data(), lineSize);
+        }
+    }
+
+    // Write-back policy: don't propagate to next level yet
+    size_t line = static_cast<size_t>(setIndex) * ways<Geometry>() + blockIndex;
+    dirtyBits[line] = true;
+    int inBlock = std::min(size, static_cast<int>(lineSize - blockOffset));
+    if (data && !tagOnly) {
+        std::memcpy(dataArena.data() + line * lineSize + blockOffset, data, inBlock);
+    }
+    if (inBlock < size) {
+        // Need to update another block for the rest of the data
+        // This is a simplification - in reality we would need multiple cache accesses
+        latency += writeWith<Geometry>(address + inBlock, data ? data + inBlock : nullptr, size - inBlock, next);
+    }
+    if (filled) {
+        updateReplacementInfo<Geometry>(setIndex, blockIndex, true);
+    }
+    return latency;
+}
+
+template <class Geometry, class Next>
+void Cache::writeToNextLevel(uint32_t address, const uint8_t* data, int size, Next& next) {
+    if (!next.present()) {
+        throw std::runtime_error("No next level cache or memory configured");
+    }
+
+    const uint32_t blockSizeBytes = lineBytes<Geometry>();
+    // Align down to the start of the block
+    uint32_t blockAddress = address & ~(blockSizeBytes - 1);
+    // Offset within that block
+    uint32_t offset       = address - blockAddress;
+
+    if (tagOnly) {
+        // Same two accesses, no bytes
+        next.read(blockAddress, nullptr, blockSizeBytes);
+        next.write(blockAddress, nullptr, blockSizeBytes);
+        return;
+    }
+
+    // 1) Read the *entire* block from the next level
+    next.read(blockAddress, writebackBuffer.data(), blockSizeBytes);
+
+    if (SIM_LOG_ENABLED(CACHE, TRACE)) {
+        SimLog::out() << "[WRITE_TO_NEXT] blockAddr=0x" << std::hex << blockAddress
+                  << " offset=" << std::dec << offset
+                  << " origData=";
+        for (auto b : writebackBuffer) SimLog::out() << std::hex << int(b) << " ";
+        SimLog::out() << std::dec << "\n";
+    }
+
+    // 2) Merge in only our dirty bytes
+    std::memcpy(writebackBuffer.data() + offset, data,
+                std::min<uint32_t>(size, blockSizeBytes - offset));
+
+    if (SIM_LOG_ENABLED(CACHE, TRACE)) {
+        SimLog::out() << "[WRITE_TO_NEXT] mergedData=";
+        for (auto b : writebackBuffer) SimLog::out() << std::hex << int(b) << " ";
+        SimLog::out() << std::dec << "\n";
+    }
+
+    // 3) Write the full block back —
+    //    if this is L1, it goes into L2; if L2, it ultimately hits DRAM.
+    next.write(blockAddress, writebackBuffer.data(), blockSizeBytes);
+}
+
+// L1 -> L2 -> main memory with the geometry of both caches fixed and every
+// level called directly; only the entry into the path is virtual. The caches
+// are the hierarchy's own objects, so statistics, flushes and checkpoints see
+// no difference. WriteThrough stores like L1DCache::write (allocate, write,
+// then write through to L2); otherwise like L1ICache.
+template <class L1Geometry, class L2Geometry, bool WriteThrough>
+class StaticCachePath : public CacheSystem {
+public:
+    StaticCachePath(Cache& l1, Cache& l2, MainMemory& memory)
+        : l1(l1), l2{&l2, MainMemoryLevel{&memory}} {}
+
+    int read(uint32_t address, uint8_t* out, int size) override {
+        return l1.readWith<L1Geometry>(address, out, size, l2);
+    }
+
+    int write(uint32_t address, const uint8_t* data, int size) override {
+        if (!WriteThrough) {
+            return l1.writeWith<L1Geometry>(address, data, size, l2);
+        }
+        l1.readWith<L1Geometry>(address, nullptr, size, l2);
+        int latency = l1.writeWith<L1Geometry>(address, data, size, l2);
+        l2.write(address, data, size);
+        return latency;
+    }
+
+private:
+    Cache& l1;
+    CacheLevel<L2Geometry, MainMemoryLevel> l2;
+};
+
+// A StaticCachePath for l1 (nextLevelCache: l2) and l2 (nextLevelCache:
+// memory) when both geometries are among the pre-instantiated ones, else null
+// and the caller keeps the dynamic path. Defined in cache_path.cpp.
+std::unique_ptr<CacheSystem> makeStaticCachePath(Cache& l1, bool writeThrough, Cache& l2, MainMemory& memory);
+
+#endif // CACHE_PATH_HPP
@@ -5,7 +5,10 @@
 #include <memory>
 #include <vector>
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include "cache.hpp"
+#include "sim_log.hpp"
 #include <stdexcept>
 #include <mutex>
 #include <string>
@@ -17,15 +20,17 @@ class MainMemory {
 private:
     std::vector<uint8_t> memory;
     int accessLatency;  // in cycles
-    std::mutex memoryMutex;
+    mutable std::mutex memoryMutex;
 
 public:
     MainMemory(int size, int accessLatency)
         : memory(size, 0), accessLatency(accessLatency) {}
     void writeBytes(uint32_t address, const std::vector<uint8_t>& data) {
-        std::cout << "[DRAM WRITE] Address 0x" << std::hex << address << " <- ";
-        for (auto b : data) std::cout << std::hex << int(b) << " ";
-        std::cout << std::endl;
+        if (SIM_LOG_ENABLED(MEM, TRACE)) {
+            SimLog::out() << "[DRAM WRITE] Address 0x" << std::hex << address << " <- ";
+            for (auto b : data) SimLog::out() << std::hex << int(b) << " ";
+            SimLog::out() << std::dec << "\n";
+        }
 
         for (size_t i = 0; i < data.size(); ++i) {
             memory[address + i] = data[i];  // memory is a std::unordered_map<uint32_t, uint8_t> or vector
@@ -45,27 +50,24 @@ public:
     // }
 
 
-    std::pair<int, std::vector<uint8_t>> read(uint32_t address, int size) {
+    // Bytes past the end of memory read as zero
+    int read(uint32_t address, uint8_t* out, int size) {
         std::lock_guard<std::mutex> lock(memoryMutex);
-        std::vector<uint8_t> data(size);
-        for (int i = 0; i < size; i++) {
-            if (address + i < memory.size()) {
-                data[i] = memory[address + i];
-            }
-        }
-        return {accessLatency, data};
+        copyOut(memory, address, out, size);
+        return accessLatency;
     }
 
     const std::vector<uint8_t>& getRawMemory() const {
         return memory;
     }
-    int write(uint32_t address, const std::vector<uint8_t>& data) {
+    // Unlocked access for the functional engine, which runs single-threaded
+    std::vector<uint8_t>& getRawMemory() {
+        return memory;
+    }
+    // Bytes past the end of memory are dropped; null data only costs the latency
+    int write(uint32_t address, const uint8_t* data, int size) {
         std::lock_guard<std::mutex> lock(memoryMutex);
-        for (size_t i = 0; i < data.size(); i++) {
-            if (address + i < memory.size()) {
-                memory[address + i] = data[i];
-            }
-        }
+        copyIn(memory, address, data, size);
         return accessLatency;
     }
 
@@ -80,6 +82,7 @@ public:
     }
 
     int32_t getWord(uint32_t address) const {
+        std::lock_guard<std::mutex> lock(memoryMutex);
         if (address + 3 < memory.size()) {
             return memory[address] |
                   (memory[address + 1] << 8) |
@@ -90,41 +93,64 @@ public:
     }
 
     int getAccessLatency() const { return accessLatency; }
+
+    // Bounded block copies shared with ScratchpadMemory
+    static void copyOut(const std::vector<uint8_t>& memory, uint32_t address, uint8_t* out, int size) {
+        if (!out) return;
+        size_t inRange = address < memory.size() ? std::min<size_t>(size, memory.size() - address) : 0;
+        if (inRange > 0) std::memcpy(out, memory.data() + address, inRange);
+        std::memset(out + inRange, 0, size - inRange);
+    }
+    static void copyIn(std::vector<uint8_t>& memory, uint32_t address, const uint8_t* data, int size) {
+        if (!data) return;
+        size_t inRange = address < memory.size() ? std::min<size_t>(size, memory.size() - address) : 0;
+        if (inRange > 0) std::memcpy(memory.data() + address, data, inRange);
+    }
 };
 
 class CacheSystem {
 public:
-    virtual std::pair<int, std::vector<uint8_t>> read(uint32_t address, int size) = 0;
-    virtual int write(uint32_t address, const std::vector<uint8_t>& data) = 0;
+    // Copies size bytes at address into out and returns the latency. A null
+    // out or data is an access without bytes (write-allocate, tag-only mode).
+    virtual int read(uint32_t address, uint8_t* out, int size) = 0;
+    virtual int write(uint32_t address, const uint8_t* data, int size) = 0;
     virtual ~CacheSystem() = default;
+
+    // Little-endian word access through read/write, using a stack buffer
+    std::pair<int, int32_t> readWord(uint32_t address) {
+        uint8_t bytes[4];
+        int latency = read(address, bytes, 4);
+        int32_t word = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
+        return {latency, word};
+    }
+    int writeWord(uint32_t address, int32_t value) {
+        uint8_t bytes[4] = {
+            static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+            static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24)
+        };
+        return write(address, bytes, 4);
+    }
 };
 
 class L1ICache : public Cache, public CacheSystem {
 public:
-    L1ICache(int cacheSize, int blockSize, int associativity, int accessLatency, ReplacementPolicy policy)
-        : Cache("L1I", cacheSize, blockSize, associativity, accessLatency, policy) {}
+    L1ICache(int cacheSize, int blockSize, int associativity, int accessLatency, ReplacementPolicy policy,
+             bool tagOnly = false)
+        : Cache("L1I", cacheSize, blockSize, associativity, accessLatency, policy, tagOnly) {}
 
-    std::pair<int, std::vector<uint8_t>> read(uint32_t address, int size) override {
-        return Cache::read(address, size);
+    int read(uint32_t address, uint8_t* out, int size) override {
+        return Cache::read(address, out, size);
     }
 
-    int write(uint32_t address, const std::vector<uint8_t>& data) override {
-        return Cache::write(address, data);
+    int write(uint32_t address, const uint8_t* data, int size) override {
+        return Cache::write(address, data, size);
     }
     void writeBackAndInvalidate() {
         CacheSystem* next = getNextLevelCache();
         if (!next) throw std::runtime_error("No L2 cache!");
 
         // (A) Write back only dirty lines
-        for (int setIdx = 0; setIdx < numSets; ++setIdx) {
-            for (auto &blk : sets[setIdx].blocks) {
-                if (blk.valid && blk.dirty) {
-                    uint32_t addr = getAddress(blk.tag, setIdx);
-                    next->write(addr, blk.data);
-                    blk.dirty = false;
-                }
-            }
-        }
+        writeBackDirtyLines(next);
 
         // (B) Invalidate everything so future accesses come from L2
         invalidateAll();
@@ -139,16 +165,17 @@ private:
         uint32_t setIndex = getSetIndex(address);
         int blockIdx      = findBlockInSet(tag, setIndex);
         return (blockIdx >= 0
-                && sets[setIndex].blocks[blockIdx].valid);
+                && validBits[lineIndex(setIndex, blockIdx)]);
     }
 
 
 public:
-    L1DCache(int cacheSize, int blockSize, int associativity, int accessLatency, ReplacementPolicy policy)
-        : Cache("L1D", cacheSize, blockSize, associativity, accessLatency, policy) {}
+    L1DCache(int cacheSize, int blockSize, int associativity, int accessLatency, ReplacementPolicy policy,
+             bool tagOnly = false)
+        : Cache("L1D", cacheSize, blockSize, associativity, accessLatency, policy, tagOnly) {}
 
-    std::pair<int, std::vector<uint8_t>> read(uint32_t address, int size) override {
-        return Cache::read(address, size);
+    int read(uint32_t address, uint8_t* out, int size) override {
+        return Cache::read(address, out, size);
     }
 
     // int write(uint32_t address, const std::vector<uint8_t>& data) override {
@@ -166,24 +193,20 @@ public:
     //
     //          return latency;
     // }
-    int write(uint32_t addr, const std::vector<uint8_t>& data) override {
+    int write(uint32_t addr, const uint8_t* data, int size) override {
         // (1) always write-allocate so the line is in L1
-        Cache::read(addr, data.size());
+        Cache::read(addr, nullptr, size);
         // (2) update L1 (and mark it dirty, if you like)
-        int latency = Cache::write(addr, data);
+        int latency = Cache::write(addr, data, size);
         // (3) write through to L2
         if (auto *l2 = getNextLevelCache()) {
-            l2->write(addr, data);
+            l2->write(addr, data, size);
         }
         return latency;
     }
 
     void invalidateAll() {
-        for (auto& set : sets) {
-            for (auto& block : set.blocks) {
-                block.valid = false;
-            }
-        }
+        std::fill(validBits.begin(), validBits.end(), 0);
     }
 
 
@@ -204,15 +227,7 @@ public:
         if (!next) throw std::runtime_error("No L2 cache!");
 
         // (A) Write back only dirty lines
-        for (int setIdx = 0; setIdx < numSets; ++setIdx) {
-            for (auto &blk : sets[setIdx].blocks) {
-                if (blk.valid && blk.dirty) {
-                    uint32_t addr = getAddress(blk.tag, setIdx);
-                    next->write(addr, blk.data);
-                    blk.dirty = false;
-                }
-            }
-        }
+        writeBackDirtyLines(next);
 
         // (B) Invalidate everything so future accesses come from L2
         invalidateAll();
@@ -227,15 +242,16 @@ public:
 
 class L2Cache : public Cache, public CacheSystem {
 public:
-    L2Cache(int cacheSize, int blockSize, int associativity, int accessLatency, ReplacementPolicy policy)
-        : Cache("L2", cacheSize, blockSize, associativity, accessLatency, policy) {}
+    L2Cache(int cacheSize, int blockSize, int associativity, int accessLatency, ReplacementPolicy policy,
+             bool tagOnly = false)
+        : Cache("L2", cacheSize, blockSize, associativity, accessLatency, policy, tagOnly) {}
 
-    std::pair<int, std::vector<uint8_t>> read(uint32_t address, int size) override {
-        return Cache::read(address, size);
+    int read(uint32_t address, uint8_t* out, int size) override {
+        return Cache::read(address, out, size);
     }
 
-    int write(uint32_t address, const std::vector<uint8_t>& data) override {
-        return Cache::write(address, data);
+    int write(uint32_t address, const uint8_t* data, int size) override {
+        return Cache::write(address, data, size);
     }
 };
 
@@ -250,24 +266,15 @@ public:
     ScratchpadMemory(int size, int accessLatency)
         : memory(size, 0), size(size), accessLatency(accessLatency) {}
 
-    std::pair<int, std::vector<uint8_t>> read(uint32_t address, int size) override {
+    int read(uint32_t address, uint8_t* out, int size) override {
         std::lock_guard<std::mutex> lock(spmMutex);
-        std::vector<uint8_t> data(size);
-        for (int i = 0; i < size; i++) {
-            if (address + i < memory.size()) {
-                data[i] = memory[address + i];
-            }
-        }
-        return {accessLatency, data};
+        MainMemory::copyOut(memory, address, out, size);
+        return accessLatency;
     }
 
-    int write(uint32_t address, const std::vector<uint8_t>& data) override {
+    int write(uint32_t address, const uint8_t* data, int size) override {
         std::lock_guard<std::mutex> lock(spmMutex);
-        for (size_t i = 0; i < data.size(); i++) {
-            if (address + i < memory.size()) {
-                memory[address + i] = data[i];
-            }
-        }
+        MainMemory::copyIn(memory, address, data, size);
         return accessLatency;
     }
 
@@ -296,6 +303,13 @@ public:
     }
 
     int getAccessLatency() const { return accessLatency; }
+
+    const std::vector<uint8_t>& getRawMemory() const {
+        return memory;
+    }
+    std::vector<uint8_t>& getRawMemory() {
+        return memory;
+    }
 };
 
 class MemorySystem : public CacheSystem {
@@ -313,19 +327,19 @@ public:
     MemorySystem(std::shared_ptr<CacheSystem> cache)
         : cacheSystem(cache), useCache(true) {}
 
-    std::pair<int, std::vector<uint8_t>> read(uint32_t address, int size) override {
+    int read(uint32_t address, uint8_t* out, int size) override {
         if (useCache) {
-            return cacheSystem->read(address, size);
+            return cacheSystem->read(address, out, size);
         } else {
-            return mainMemory->read(address, size);
+            return mainMemory->read(address, out, size);
         }
     }
 
-    int write(uint32_t address, const std::vector<uint8_t>& data) override {
+    int write(uint32_t address, const uint8_t* data, int size) override {
         if (useCache) {
-            return cacheSystem->write(address, data);
+            return cacheSystem->write(address, data, size);
         } else {
-            return mainMemory->write(address, data);
+            return mainMemory->write(address, data, size);
         }
     }
 };
@@ -1,11 +1,38 @@
 #ifndef CENTRALIZED_FETCH_HPP
 #define CENTRALIZED_FETCH_HPP
 
+#include <algorithm>
+#include <climits>
 #include <vector>
 #include <string>
 #include "pipelined_core.hpp"
 
+// True when fetchForCore would fetch for this core right now
+bool canFetch(const PipelinedCore& core, const std::vector<std::string>& program);
+
+// Fetches at most one instruction for a single core (the relaxed parallel
+// engine fetches for each core right after clocking it)
+void fetchForCore(PipelinedCore& core, const std::vector<std::string>& program);
+
 // Centralized fetch unit that handles instruction fetching for all cores
 void centralizedFetch(std::vector<PipelinedCore>& cores, const std::vector<std::string>& program);
 
+// Idle-cycle skipping across cores: the number of cycles the engine can jump
+// over at once because every core still running (running(i)) has at least
+// that many idle cycles already accounted for (idleAhead, see
+// PipelinedCore::skipIdleCycles) and no other core can fetch. 0 if none.
+template <typename Running>
+int idleCyclesForAll(const std::vector<PipelinedCore>& cores, const std::vector<std::string>& program,
+                     const std::vector<int>& idleAhead, Running running) {
+    int cycles = INT_MAX;
+    for (size_t i = 0; i < cores.size() && cycles > 0; i++) {
+        if (running(i)) {
+            cycles = std::min(cycles, idleAhead[i]);
+        } else if (canFetch(cores[i], program)) {
+            cycles = 0;
+        }
+    }
+    return cycles == INT_MAX ? 0 : cycles;
+}
+
 #endif // CENTRALIZED_FETCH_HPP
\ No newline at end of file
@@ -0,0 +1,119 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Simulator checkpoint file: a header followed by tagged, length-prefixed
+// sections, so a reader can skip sections it does not know or cannot use.
+// Values are stored in host byte order, like the pipeline trace.
+//
+//   header  : "SCKP", uint32 version, uint32 numCores, uint64 program hash, uint32 flags
+//   section : char tag[4], uint64 length, payload
+//   last    : "END " section with no payload
+namespace Checkpoint {
+    constexpr char MAGIC[4] = {'S', 'C', 'K', 'P'};
+    // 2: caches with a non-power-of-two set count store blockNumber / numSets as the tag
+    constexpr uint32_t VERSION = 2;
+    constexpr uint32_t FLAG_CACHES = 1u << 0;
+    // Saved from a tag-only hierarchy: the cache sections carry no line data
+    constexpr uint32_t FLAG_TAG_ONLY = 1u << 1;
+
+    // FNV-1a; std::hash is not stable across standard libraries
+    inline uint64_t hash(const std::string &text, uint64_t seed = 1469598103934665603ull) {
+        uint64_t value = seed;
+        for (unsigned char c: text) {
+            value ^= c;
+            value *= 1099511628211ull;
+        }
+        return value;
+    }
+}
+
+class CheckpointWriter {
+public:
+    template <typename T>
+    void write(const T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values are written as-is");
+        buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    // Length-prefixed byte array
+    void writeBytes(const std::vector<uint8_t> &bytes) {
+        write<uint64_t>(bytes.size());
+        writeRaw(bytes.data(), bytes.size());
+    }
+
+    void writeRaw(const void *data, size_t size) {
+        buffer.append(static_cast<const char *>(data), size);
+    }
+
+    void writeSection(const char (&tag)[5], const CheckpointWriter &section) {
+        buffer.append(tag, 4);
+        write<uint64_t>(section.buffer.size());
+        buffer.append(section.buffer);
+    }
+
+    const std::string &data() const { return buffer; }
+
+private:
+    std::string buffer;
+};
+
+class CheckpointReader {
+public:
+    CheckpointReader() = default;
+    explicit CheckpointReader(std::string bytes) : buffer(std::move(bytes)) {}
+
+    // Throws std::runtime_error when the data ends early
+    template <typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values are read as-is");
+        T value;
+        readRaw(&value, sizeof(T));
+        return value;
+    }
+
+    std::vector<uint8_t> readBytes() {
+        uint64_t size = read<uint64_t>();
+        require(size);
+        std::vector<uint8_t> bytes(size);
+        readRaw(bytes.data(), size);
+        return bytes;
+    }
+
+    void readRaw(void *data, size_t size) {
+        require(size);
+        std::memcpy(data, buffer.data() + position, size);
+        position += size;
+    }
+
+    bool atEnd() const { return position >= buffer.size(); }
+
+    // Reads the next section header and hands its payload to a separate reader
+    void readSection(std::string &tag, CheckpointReader &section) {
+        require(4);
+        tag.assign(buffer, position, 4);
+        position += 4;
+        uint64_t length = read<uint64_t>();
+        require(length);
+        section = CheckpointReader(buffer.substr(position, length));
+        position += length;
+    }
+
+private:
+    std::string buffer;
+    size_t position = 0;
+
+    void require(uint64_t size) const {
+        if (size > buffer.size() - position) {
+            throw std::runtime_error("Checkpoint is truncated or corrupt");
+        }
+    }
+};
+
+#endif // CHECKPOINT_HPP
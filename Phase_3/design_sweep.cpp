@@ -0,0 +1,295 @@
+#include "design_sweep.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+    std::string trimmed(const std::string &s) {
+        size_t first = s.find_first_not_of(" \t\r");
+        if (first == std::string::npos) {
+            return "";
+        }
+        return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+    }
+
+    std::vector<std::string> splitList(const std::string &s) {
+        std::vector<std::string> items;
+        std::istringstream in(s);
+        std::string item;
+        while (std::getline(in, item, ',')) {
+            item = trimmed(item);
+            if (!item.empty()) {
+                items.push_back(item);
+            }
+        }
+        return items;
+    }
+
+    double hitRate(const MemoryHierarchy::CacheStats &stats) {
+        return stats.accesses > 0 ? static_cast<double>(stats.hits) / stats.accesses : 0.0;
+    }
+
+    double ipc(const BatchResult &result) {
+        return result.cycles > 0 ? static_cast<double>(result.instructions) / result.cycles : 0.0;
+    }
+
+    std::string jsonString(const std::string &s) {
+        std::string out = "\"";
+        for (char c: s) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+            }
+            out += c;
+        }
+        return out + "\"";
+    }
+}
+
+DesignSweep::DesignSweep(const std::string &filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open sweep file: " + filename);
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = trimmed(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+        try {
+            size_t equals = line.find('=');
+            if (equals == std::string::npos) {
+                throw std::invalid_argument("expected KEY=VALUE");
+            }
+            std::string key = trimmed(line.substr(0, equals));
+            std::string value = trimmed(line.substr(equals + 1));
+            if (key == "program") {
+                programs = splitList(value);
+            } else if (key == "base") {
+                std::ifstream config(value);
+                if (!config.is_open()) {
+                    throw std::invalid_argument("could not open " + value);
+                }
+                base.read(config);
+            } else if (key == "sample") {
+                std::istringstream words(value);
+                std::string method;
+                words >> method >> sampleCount;
+                if (method != "lhs" || sampleCount < 1) {
+                    throw std::invalid_argument("expected 'sample=lhs <points> [seed]'");
+                }
+                words >> seed;
+            } else if (key == "forwarding") {
+                forwarding = value == "y" || value == "Y";
+            } else if (key == "cores") {
+                numCores = std::stoi(value);
+            } else {
+                Parameter parameter{key, expandValues(value)};
+                CacheConfig check;
+                for (const auto &v: parameter.values) {
+                    if (!check.set(key, v)) {
+                        throw std::invalid_argument("unknown parameter or value " + key + "=" + v);
+                    }
+                }
+                parameters.push_back(parameter);
+            }
+        } catch (const std::exception &e) {
+            throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": " + e.what());
+        }
+    }
+    if (programs.empty()) {
+        throw std::runtime_error(filename + ": no program");
+    }
+}
+
+std::vector<std::string> DesignSweep::expandValues(const std::string &spec) {
+    size_t dots = spec.find("..");
+    if (dots == std::string::npos) {
+        std::vector<std::string> values = splitList(spec);
+        if (values.empty()) {
+            throw std::invalid_argument("no values");
+        }
+        return values;
+    }
+
+    // lo..hi, lo..hi*factor
+    std::string upper = spec.substr(dots + 2);
+    size_t star = upper.find('*');
+    long long low = std::stoll(spec.substr(0, dots));
+    long long high = std::stoll(upper.substr(0, star));
+    long long factor = star == std::string::npos ? 0 : std::stoll(upper.substr(star + 1));
+    if (high < low || (star != std::string::npos && (factor < 2 || low < 1))) {
+        throw std::invalid_argument("bad range " + spec);
+    }
+    std::vector<std::string> values;
+    for (long long v = low; v <= high; v = factor ? v * factor : v + 1) {
+        values.push_back(std::to_string(v));
+    }
+    return values;
+}
+
+std::vector<std::vector<size_t>> DesignSweep::fullProduct() const {
+    std::vector<std::vector<size_t>> levels(1);
+    for (const auto &parameter: parameters) {
+        std::vector<std::vector<size_t>> next;
+        for (const auto &prefix: levels) {
+            for (size_t v = 0; v < parameter.values.size(); v++) {
+                next.push_back(prefix);
+                next.back().push_back(v);
+            }
+        }
+        levels = std::move(next);
+    }
+    return levels;
+}
+
+std::vector<std::vector<size_t>> DesignSweep::latinHypercube() const {
+    // Each parameter's range is cut into sampleCount equal strata and every
+    // stratum is used exactly once; a random point inside the stratum picks
+    // the value. With fewer values than strata, values repeat evenly.
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> inside(0.0, 1.0);
+    std::vector<std::vector<size_t>> levels(sampleCount);
+    for (const auto &parameter: parameters) {
+        std::vector<int> strata(sampleCount);
+        for (int i = 0; i < sampleCount; i++) {
+            strata[i] = i;
+        }
+        std::shuffle(strata.begin(), strata.end(), random);
+        for (int i = 0; i < sampleCount; i++) {
+            double position = (strata[i] + inside(random)) / sampleCount;
+            size_t level = std::min(parameter.values.size() - 1,
+                                    static_cast<size_t>(position * parameter.values.size()));
+            levels[i].push_back(level);
+        }
+    }
+    return levels;
+}
+
+void DesignSweep::enumeratePoints() {
+    points.clear();
+    duplicates = 0;
+    std::vector<std::vector<size_t>> levels = sampleCount > 0 ? latinHypercube() : fullProduct();
+    std::unordered_set<std::string> seen;
+    for (const auto &program: programs) {
+        for (const auto &level: levels) {
+            Point point;
+            point.program = program;
+            point.config = base;
+            for (size_t p = 0; p < parameters.size(); p++) {
+                point.values.push_back(parameters[p].values[level[p]]);
+                point.config.set(parameters[p].key, point.values.back());
+            }
+            if (!seen.insert(program + "\n" + point.config.toString()).second) {
+                duplicates++;
+                continue;
+            }
+            points.push_back(point);
+        }
+    }
+}
+
+void DesignSweep::run(int threads) {
+    enumeratePoints();
+
+    std::vector<BatchJob> jobs;
+    for (size_t i = 0; i < points.size(); i++) {
+        BatchJob job;
+        job.name = "point" + std::to_string(i);
+        job.programFile = points[i].program;
+        job.cacheConfig = points[i].config;
+        job.numCores = numCores;
+        job.forwarding = forwarding;
+        jobs.push_back(job);
+    }
+    std::vector<BatchResult> results = BatchRunner(threads).run(jobs);
+    for (size_t i = 0; i < points.size(); i++) {
+        points[i].result = std::move(results[i]);
+    }
+}
+
+void DesignSweep::printTable(std::ostream &out) const {
+    out << std::left << std::setw(8) << "Point" << std::setw(20) << "Program";
+    for (const auto &parameter: parameters) {
+        out << std::setw(std::max<int>(parameter.key.size(), 6) + 2) << parameter.key;
+    }
+    out << std::right << std::setw(12) << "Cycles" << std::setw(8) << "IPC"
+        << std::setw(9) << "L1I hit" << std::setw(9) << "L1D hit" << std::setw(9) << "L2 hit" << "\n";
+    out << std::fixed;
+    for (const auto &point: points) {
+        out << std::left << std::setw(8) << point.result.name << std::setw(20) << point.program;
+        for (size_t p = 0; p < parameters.size(); p++) {
+            out << std::setw(std::max<int>(parameters[p].key.size(), 6) + 2) << point.values[p];
+        }
+        out << std::right;
+        if (!point.result.error.empty()) {
+            out << "  failed: " << point.result.error << "\n";
+            continue;
+        }
+        out << std::setw(12) << point.result.cycles << std::setw(8) << std::setprecision(2) << ipc(point.result)
+            << std::setw(8) << hitRate(point.result.l1i) * 100.0 << "%"
+            << std::setw(8) << hitRate(point.result.l1d) * 100.0 << "%"
+            << std::setw(8) << hitRate(point.result.l2) * 100.0 << "%\n";
+    }
+    out.unsetf(std::ios::floatfield);
+    out << std::setprecision(6);
+}
+
+void DesignSweep::writeCsv(std::ostream &out) const {
+    out << "point,program";
+    for (const auto &parameter: parameters) {
+        out << "," << parameter.key;
+    }
+    out << ",status,cycles,instructions,ipc,l1i_hit_rate,l1d_hit_rate,l2_hit_rate,seconds,error\n";
+    for (const auto &point: points) {
+        const BatchResult &result = point.result;
+        out << result.name << "," << point.program;
+        for (const auto &value: point.values) {
+            out << "," << value;
+        }
+        if (!result.error.empty()) {
+            std::string error = result.error;
+            std::replace(error.begin(), error.end(), ',', ';');
+            out << ",failed,,,,,,,," << error << "\n";
+            continue;
+        }
+        out << ",ok," << result.cycles << "," << result.instructions << "," << ipc(result) << ","
+            << hitRate(result.l1i) << "," << hitRate(result.l1d) << "," << hitRate(result.l2) << ","
+            << result.seconds << ",\n";
+    }
+}
+
+void DesignSweep::writeJson(std::ostream &out) const {
+    out << "{\n  \"parameters\": [";
+    for (size_t p = 0; p < parameters.size(); p++) {
+        out << (p ? ", " : "") << jsonString(parameters[p].key);
+    }
+    out << "],\n  \"duplicates_skipped\": " << duplicates << ",\n  \"points\": [";
+    for (size_t i = 0; i < points.size(); i++) {
+        const Point &point = points[i];
+        const BatchResult &result = point.result;
+        out << (i ? "," : "") << "\n    {\"point\": " << jsonString(result.name)
+            << ", \"program\": " << jsonString(point.program) << ", \"config\": {";
+        for (size_t p = 0; p < parameters.size(); p++) {
+            out << (p ? ", " : "") << jsonString(parameters[p].key) << ": " << jsonString(point.values[p]);
+        }
+        out << "}, ";
+        if (!result.error.empty()) {
+            out << "\"status\": \"failed\", \"error\": " << jsonString(result.error) << "}";
+            continue;
+        }
+        out << "\"status\": \"ok\", \"cycles\": " << result.cycles
+            << ", \"instructions\": " << result.instructions << ", \"ipc\": " << ipc(result)
+            << ", \"l1i_hit_rate\": " << hitRate(result.l1i) << ", \"l1d_hit_rate\": " << hitRate(result.l1d)
+            << ", \"l2_hit_rate\": " << hitRate(result.l2) << ", \"seconds\": " << result.seconds << "}";
+    }
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,76 @@
+#ifndef DESIGN_SWEEP_HPP
+#define DESIGN_SWEEP_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "batch_runner.hpp"
+#include "cache_config.hpp"
+
+// Design-space exploration over the cache configuration. A sweep file lists
+// the values each swept parameter takes, one KEY=VALUE line per parameter:
+//
+//   program=bubble_sort.txt,algo1.txt    every point runs every program
+//   base=cacheconfig                     unswept parameters (default: built-in defaults)
+//   sample=lhs 20 7                      Latin-hypercube sample of 20 points, seed 7
+//                                        (default: the full Cartesian product)
+//   forwarding=n                         as in a batch job
+//   cores=4
+//   L1D_SIZE=1024,4096,16384             any cache configuration key: a list,
+//   L1D_LATENCY=1..4                     an arithmetic range (step 1),
+//   L2_SIZE=65536..524288*2              or a geometric one (factor 2)
+//   L2_POLICY=LRU,FIFO
+//
+// Points with the same program and the same resulting configuration are run
+// once. Every point runs in its own simulator on the batch runner's pool; a
+// point whose caches cannot be built (or that fails otherwise) is reported as
+// failed without stopping the rest.
+class DesignSweep {
+public:
+    struct Parameter {
+        std::string key;
+        std::vector<std::string> values;
+    };
+
+    struct Point {
+        std::string program;
+        std::vector<std::string> values;    // one per swept parameter
+        CacheConfig config;
+        BatchResult result;
+    };
+
+    // Throws std::runtime_error naming the line for a bad sweep file
+    explicit DesignSweep(const std::string& filename);
+
+    // Enumerates (or samples) and deduplicates the points, then runs them
+    void run(int threads = 0);
+
+    const std::vector<Parameter>& getParameters() const { return parameters; }
+    const std::vector<Point>& getPoints() const { return points; }
+    size_t getDuplicateCount() const { return duplicates; }
+
+    void printTable(std::ostream& out) const;
+    void writeCsv(std::ostream& out) const;
+    void writeJson(std::ostream& out) const;
+
+private:
+    std::vector<std::string> programs;
+    CacheConfig base;
+    std::vector<Parameter> parameters;
+    int numCores = 4;
+    bool forwarding = true;
+    int sampleCount = 0;                    // 0: full product
+    uint32_t seed = 1;
+
+    std::vector<Point> points;
+    size_t duplicates = 0;
+
+    static std::vector<std::string> expandValues(const std::string& spec);
+    // Level index of every parameter, per configuration
+    std::vector<std::vector<size_t>> fullProduct() const;
+    std::vector<std::vector<size_t>> latinHypercube() const;
+    void enumeratePoints();
+};
+
+#endif // DESIGN_SWEEP_HPP
@@ -0,0 +1,40 @@
+#ifndef FAST_DIVISOR_HPP
+#define FAST_DIVISOR_HPP
+
+#include <cstdint>
+
+// Division and remainder of 32-bit values by a divisor fixed at construction,
+// without a divide instruction (Lemire, Kaser and Kurz, "Faster Remainder by
+// Direct Computation"): magic = ceil(2^64 / divisor), and both results come
+// from 64x64 -> 128-bit multiplies, exact for every 32-bit numerator when
+// divisor > 1. Compilers without a 128-bit integer type use / and %.
+class FastDivisor {
+public:
+    explicit FastDivisor(uint32_t divisor = 2)
+        : divisor(divisor), magic(UINT64_MAX / divisor + 1) {}
+
+    uint32_t get() const { return divisor; }
+
+    uint32_t quotient(uint32_t value) const {
+#ifdef __SIZEOF_INT128__
+        return static_cast<uint32_t>((static_cast<unsigned __int128>(magic) * value) >> 64);
+#else
+        return value / divisor;
+#endif
+    }
+
+    uint32_t remainder(uint32_t value) const {
+#ifdef __SIZEOF_INT128__
+        uint64_t fraction = magic * value;
+        return static_cast<uint32_t>((static_cast<unsigned __int128>(fraction) * divisor) >> 64);
+#else
+        return value % divisor;
+#endif
+    }
+
+private:
+    uint32_t divisor;
+    uint64_t magic;
+};
+
+#endif // FAST_DIVISOR_HPP
@@ -0,0 +1,415 @@
+#include "functional_engine.hpp"
+#include "sim_log.hpp"
+#include <limits>
+#include <stdexcept>
+
+// GCC and Clang support computed goto ("labels as values"): every handler jumps
+// straight to the next one instead of returning to a shared switch. Other
+// compilers get the same handlers inside a switch.
+#if defined(__GNUC__)
+#define FUNCTIONAL_THREADED_DISPATCH 1
+#else
+#define FUNCTIONAL_THREADED_DISPATCH 0
+#endif
+
+namespace {
+    // Same byte order and bounds rule as MainMemory::getWord/setWord
+    inline int32_t readWord(const uint8_t *memory, size_t size, uint32_t address) {
+        if (static_cast<size_t>(address) + 3 >= size) {
+            return 0;
+        }
+        return memory[address] |
+               (memory[address + 1] << 8) |
+               (memory[address + 2] << 16) |
+               (memory[address + 3] << 24);
+    }
+
+    inline void writeWord(uint8_t *memory, size_t size, uint32_t address, int32_t value) {
+        if (static_cast<size_t>(address) + 3 >= size) {
+            return;
+        }
+        memory[address] = value & 0xFF;
+        memory[address + 1] = (value >> 8) & 0xFF;
+        memory[address + 2] = (value >> 16) & 0xFF;
+        memory[address + 3] = (value >> 24) & 0xFF;
+    }
+}
+
+void FunctionalEngine::setProgram(std::shared_ptr<const std::vector<Instruction>> newProgram) {
+    program = newProgram;
+    ops.clear();
+    ops.reserve(program->size() + 1);
+    for (const auto &inst: *program) {
+        ops.push_back(translate(inst));
+    }
+    // Falling off the end of the program lands here instead of being range checked
+    ops.push_back(Op{Kind::END, FunctionalCoreState::SINK_REGISTER, 0, 0, 0, 0});
+    markerPC = -1;
+    blockLengths.assign(ops.size(), -1);
+}
+
+FunctionalEngine::Op FunctionalEngine::translate(const Instruction &inst) {
+    auto source = [](int reg) -> uint8_t {
+        return (reg >= 0 && reg < 32) ? static_cast<uint8_t>(reg) : 0;
+    };
+    // x0 and x31 (core id) are never written, matching PipelinedCore::setRegister
+    auto destination = [](int reg) -> uint8_t {
+        return (reg > 0 && reg < 31) ? static_cast<uint8_t>(reg)
+                                     : static_cast<uint8_t>(FunctionalCoreState::SINK_REGISTER);
+    };
+
+    Op op{Kind::NOP, destination(inst.rd), source(inst.rs1), source(inst.rs2),
+          inst.immediate, inst.targetPC};
+
+    switch (inst.op) {
+        case Opcode::ADD:    op.kind = Kind::ADD; break;
+        case Opcode::ADDI:   op.kind = Kind::ADDI; break;
+        case Opcode::SUB:    op.kind = Kind::SUB; break;
+        case Opcode::SLT:    op.kind = Kind::SLT; break;
+        case Opcode::MUL:    op.kind = Kind::MUL; break;
+        case Opcode::LW:     op.kind = Kind::LW; break;
+        case Opcode::LW_SPM: op.kind = Kind::LW_SPM; break;
+        case Opcode::SW:     op.kind = Kind::SW; break;
+        case Opcode::SW_SPM: op.kind = Kind::SW_SPM; break;
+        case Opcode::BEQ:
+            // "beq x31, <cid>, label": rs2 holds the core id, not a register
+            if (inst.rs1 == 31) {
+                op.kind = Kind::BEQ_CID;
+                op.immediate = inst.rs2;
+            } else {
+                op.kind = Kind::BEQ;
+            }
+            break;
+        case Opcode::BNE:    op.kind = Kind::BNE; break;
+        case Opcode::BLT:    op.kind = Kind::BLT; break;
+        case Opcode::BGE:    op.kind = Kind::BGE; break;
+        case Opcode::JAL:    op.kind = Kind::JAL; break;
+        case Opcode::LA:     op.kind = Kind::LA; break;
+        case Opcode::SYNC:   op.kind = Kind::SYNC; break;
+        case Opcode::INVLD1: op.kind = Kind::INVLD1; break;
+        case Opcode::HALT:   op.kind = Kind::HALT; break;
+        default:             op.kind = Kind::NOP; break;
+    }
+    return op;
+}
+
+void FunctionalEngine::placeMarker(int pc) {
+    if (markerPC == pc) {
+        return;
+    }
+    if (markerPC >= 0) {
+        ops[markerPC] = markerSaved;
+    }
+    markerPC = -1;
+    if (pc >= 0 && pc < static_cast<int>(program->size())) {
+        markerSaved = ops[pc];
+        ops[pc].kind = Kind::MARKER;
+        markerPC = pc;
+    }
+}
+
+int FunctionalEngine::translateBlock(int start) {
+    // The stop marker moves between runs, so blocks are cut from the program
+    // as it is without it
+    int length = 0;
+    for (int pc = start;; pc++) {
+        Kind kind = pc == markerPC ? markerSaved.kind : ops[pc].kind;
+        if (kind == Kind::SYNC || kind == Kind::HALT || kind == Kind::END) {
+            break;
+        }
+        length++;
+        if (kind >= Kind::BEQ && kind <= Kind::JAL) {
+            break;
+        }
+    }
+    blockLengths[start] = length;
+    return length;
+}
+
+void FunctionalEngine::run(std::vector<FunctionalCoreState> &cores, uint64_t maxInstructions,
+                           int marker, bool warmCaches) {
+    if (!program || !memoryHierarchy) {
+        throw std::logic_error("Functional engine needs a program and a memory hierarchy");
+    }
+    placeMarker(marker);
+    numCores = static_cast<int>(cores.size());
+
+    // Without warming, loads and stores bypass the caches, so anything they hold
+    // must be in main memory first and must not be read back stale afterwards
+    if (!warmCaches) {
+        memoryHierarchy->writeBackAndInvalidateAll();
+    }
+
+    std::vector<uint64_t> startCount;
+    for (auto &core: cores) {
+        startCount.push_back(core.instructions);
+        if (core.stop != FunctionalStop::HALTED && core.stop != FunctionalStop::END_OF_PROGRAM) {
+            core.stop = FunctionalStop::RUNNING;
+        }
+    }
+
+    while (true) {
+        for (size_t i = 0; i < cores.size(); i++) {
+            FunctionalCoreState &core = cores[i];
+            if (core.stop != FunctionalStop::RUNNING) {
+                continue;
+            }
+            uint64_t budget = std::numeric_limits<uint64_t>::max();
+            if (maxInstructions > 0) {
+                uint64_t used = core.instructions - startCount[i];
+                budget = used >= maxInstructions ? 0 : maxInstructions - used;
+            }
+            core.stop = warmCaches ? execute<true>(core, budget) : execute<false>(core, budget);
+        }
+
+        // Every core runs up to its next barrier in turn; once all of them wait
+        // there the barrier opens and the sync counts as executed
+        bool allWaiting = !cores.empty();
+        for (const auto &core: cores) {
+            allWaiting = allWaiting && core.stop == FunctionalStop::SYNC;
+        }
+        if (!allWaiting) {
+            break;
+        }
+
+        SIM_LOG(SYNC, INFO, "[Functional] All cores reached SYNC, releasing barrier\n");
+        if (warmCaches) {
+            for (size_t c = 0; c < cores.size(); c++) {
+                memoryHierarchy->flushL1D(static_cast<int>(c));
+            }
+        }
+        for (auto &core: cores) {
+            core.pc++;
+            core.instructions++;
+            core.stop = FunctionalStop::RUNNING;
+        }
+    }
+}
+
+template <bool WarmCaches>
+FunctionalStop FunctionalEngine::execute(FunctionalCoreState &core, uint64_t budget) {
+    if (budget == 0) {
+        return FunctionalStop::LIMIT;
+    }
+    if (core.pc < 0 || core.pc >= static_cast<int>(program->size())) {
+        return FunctionalStop::END_OF_PROGRAM;
+    }
+
+    Op *const base = ops.data();
+    const Op *op = base + core.pc;
+    const Op *blockStart = op;
+    int *const regs = core.registers.data();
+    const int coreId = core.coreId;
+    MemoryHierarchy *const hierarchy = memoryHierarchy.get();
+    std::vector<uint8_t> &mainMemory = hierarchy->getMainMemory()->getRawMemory();
+    uint8_t *const memory = mainMemory.data();
+    const size_t memorySize = mainMemory.size();
+
+    uint64_t executed = 0;          // instructions before blockStart
+    FunctionalStop stop = FunctionalStop::RUNNING;
+    int limitPC = -1;               // where a LIMIT stop is planted, if anywhere
+    Op limitSaved{};
+
+    // L1I only sees real instructions, not the END/MARKER slots
+#define FE_WARM_FETCH()                                                                    \
+    do {                                                                                   \
+        if constexpr (WarmCaches) {                                                        \
+            if (op->kind < Kind::END) {                                                    \
+                hierarchy->fetchInstruction(coreId, static_cast<uint32_t>(op - base) * 4); \
+            }                                                                              \
+        }                                                                                  \
+    } while (0)
+
+#if FUNCTIONAL_THREADED_DISPATCH
+    static const void *const handlers[static_cast<int>(Kind::COUNT)] = {
+        &&op_ADD, &&op_ADDI, &&op_SUB, &&op_SLT, &&op_MUL,
+        &&op_LW, &&op_LW_SPM, &&op_SW, &&op_SW_SPM,
+        &&op_BEQ, &&op_BNE, &&op_BLT, &&op_BGE, &&op_BEQ_CID, &&op_JAL, &&op_LA,
+        &&op_SYNC, &&op_INVLD1, &&op_HALT, &&op_NOP,
+        &&op_END, &&op_MARKER, &&op_LIMIT
+    };
+#define FE_DISPATCH() goto *handlers[static_cast<int>(op->kind)]
+#define FE_CASE(name) op_##name:
+#else
+#define FE_DISPATCH() goto dispatch
+#define FE_CASE(name) case Kind::name:
+#endif
+
+    // Inside a block: straight on to the next handler
+#define FE_NEXT()                                 \
+    do {                                          \
+        FE_WARM_FETCH();                          \
+        FE_DISPATCH();                            \
+    } while (0)
+
+    // Start of a block: stop if the budget is used up; if the block would run
+    // past it, plant a LIMIT stop where it runs out (restored on the way out)
+#define FE_ENTER_BLOCK()                                                             \
+    do {                                                                             \
+        blockStart = op;                                                             \
+        if (executed == budget) {                                                    \
+            stop = FunctionalStop::LIMIT;                                            \
+            goto done;                                                               \
+        }                                                                            \
+        const int startPC = static_cast<int>(op - base);                             \
+        int length = blockLengths[startPC];                                          \
+        if (length < 0) {                                                            \
+            length = translateBlock(startPC);                                        \
+        }                                                                            \
+        if (budget - executed < static_cast<uint64_t>(length)) {                     \
+            limitPC = startPC + static_cast<int>(budget - executed);                 \
+            limitSaved = base[limitPC];                                              \
+            base[limitPC].kind = Kind::LIMIT;                                        \
+        }                                                                            \
+        FE_NEXT();                                                                   \
+    } while (0)
+
+    // A branch or jal closes its block and counts it
+#define FE_BRANCH(taken)                                                             \
+    do {                                                                             \
+        const Op *next = (taken) ? base + op->target : op + 1;                       \
+        executed += op - blockStart + 1;                                             \
+        op = next;                                                                   \
+        FE_ENTER_BLOCK();                                                            \
+    } while (0)
+
+    // Stopping inside a block counts the instructions before this one
+#define FE_STOP(reason)                                                              \
+    do {                                                                             \
+        executed += op - blockStart;                                                 \
+        stop = FunctionalStop::reason;                                               \
+    } while (0)
+
+#if FUNCTIONAL_THREADED_DISPATCH
+    FE_ENTER_BLOCK();
+    {
+#else
+    FE_ENTER_BLOCK();
+dispatch:
+    switch (op->kind) {
+#endif
+    FE_CASE(ADD)
+        regs[op->rd] = regs[op->rs1] + regs[op->rs2];
+        ++op;
+        FE_NEXT();
+    FE_CASE(ADDI)
+        regs[op->rd] = regs[op->rs1] + op->immediate;
+        ++op;
+        FE_NEXT();
+    FE_CASE(SUB)
+        regs[op->rd] = regs[op->rs1] - regs[op->rs2];
+        ++op;
+        FE_NEXT();
+    FE_CASE(SLT)
+        regs[op->rd] = regs[op->rs1] < regs[op->rs2] ? 1 : 0;
+        ++op;
+        FE_NEXT();
+    FE_CASE(MUL)
+        regs[op->rd] = regs[op->rs1] * regs[op->rs2];
+        ++op;
+        FE_NEXT();
+    FE_CASE(LW) {
+        uint32_t address = static_cast<uint32_t>(regs[op->rs1] + op->immediate) & ~0x3u;
+        if constexpr (WarmCaches) {
+            regs[op->rd] = hierarchy->loadWord(coreId, address).second;
+        } else {
+            regs[op->rd] = readWord(memory, memorySize, address);
+        }
+        ++op;
+        FE_NEXT();
+    }
+    FE_CASE(LW_SPM)
+        regs[op->rd] = hierarchy->loadWordFromSPM(
+            coreId, static_cast<uint32_t>(regs[op->rs1] + op->immediate)).second;
+        ++op;
+        FE_NEXT();
+    FE_CASE(SW) {
+        uint32_t address = static_cast<uint32_t>(regs[op->rs1] + op->immediate) & ~0x3u;
+        if constexpr (WarmCaches) {
+            hierarchy->storeWord(coreId, address, regs[op->rs2]);
+        } else {
+            writeWord(memory, memorySize, address, regs[op->rs2]);
+        }
+        ++op;
+        FE_NEXT();
+    }
+    FE_CASE(SW_SPM)
+        hierarchy->storeWordToSPM(coreId, static_cast<uint32_t>(regs[op->rs1] + op->immediate),
+                                  regs[op->rs2]);
+        ++op;
+        FE_NEXT();
+    FE_CASE(BEQ)
+        FE_BRANCH(regs[op->rs1] == regs[op->rs2]);
+    FE_CASE(BNE)
+        FE_BRANCH(regs[op->rs1] != regs[op->rs2]);
+    FE_CASE(BLT)
+        FE_BRANCH(regs[op->rs1] < regs[op->rs2]);
+    FE_CASE(BGE)
+        FE_BRANCH(regs[op->rs1] >= regs[op->rs2]);
+    FE_CASE(BEQ_CID)
+        FE_BRANCH(coreId == op->immediate);
+    FE_CASE(JAL)
+        // Return address is the instruction after the jal
+        regs[op->rd] = static_cast<int>(op - base) + 1;
+        FE_BRANCH(true);
+    FE_CASE(LA)
+        regs[op->rd] = op->immediate;
+        ++op;
+        FE_NEXT();
+    FE_CASE(SYNC)
+        FE_STOP(SYNC);
+        goto done;
+    FE_CASE(INVLD1)
+        if constexpr (WarmCaches) {
+            hierarchy->invalidateL1D(coreId);
+        }
+        ++op;
+        FE_NEXT();
+    FE_CASE(HALT)
+        // Same write-back as a HALT retiring in the pipelined core
+        if constexpr (WarmCaches) {
+            for (int c = 0; c < numCores; ++c) {
+                hierarchy->flushL1D(c);
+            }
+            hierarchy->flushCache();
+        }
+        FE_STOP(HALTED);
+        SIM_LOG(EXEC, INFO, "[Core " << coreId << "] Functional HALT after "
+                << core.instructions + executed << " instructions\n");
+        ++op;
+        goto done;
+    FE_CASE(NOP)
+        ++op;
+        FE_NEXT();
+    FE_CASE(END)
+        FE_STOP(END_OF_PROGRAM);
+        goto done;
+    FE_CASE(MARKER)
+        FE_STOP(MARKER);
+        goto done;
+    FE_CASE(LIMIT)
+        FE_STOP(LIMIT);
+        goto done;
+#if !FUNCTIONAL_THREADED_DISPATCH
+    default:
+        ++op;
+        FE_NEXT();
+#endif
+    }
+
+#undef FE_STOP
+#undef FE_BRANCH
+#undef FE_ENTER_BLOCK
+#undef FE_NEXT
+#undef FE_CASE
+#undef FE_DISPATCH
+#undef FE_WARM_FETCH
+
+done:
+    if (limitPC >= 0) {
+        base[limitPC] = limitSaved;
+    }
+    core.pc = static_cast<int>(op - base);
+    core.instructions += executed;
+    return stop;
+}
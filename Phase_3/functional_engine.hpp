@@ -0,0 +1,107 @@
+#ifndef FUNCTIONAL_ENGINE_HPP
+#define FUNCTIONAL_ENGINE_HPP
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "pipeline.hpp"
+#include "memory_hierarchy.hpp"
+
+// How far a fast-forward goes before handing over to the pipelined cores
+struct FastForwardOptions {
+    uint64_t maxInstructions = 0;   // per core; 0 = no limit
+    std::string stopLabel;          // stop before the instruction at this label; empty = none
+    bool warmCaches = false;        // send fetches, loads and stores through L1I/L1D/L2
+};
+
+// Why a core stopped executing in functional mode
+enum class FunctionalStop : uint8_t {
+    RUNNING,
+    SYNC,           // waiting at a barrier (the sync has not executed yet)
+    LIMIT,          // instruction budget used up
+    MARKER,         // pc reached the stop label
+    HALTED,
+    END_OF_PROGRAM  // pc ran past the last instruction
+};
+
+// Architectural state of one core. registers[32] is a write sink: writes to
+// x0, x31 and "no destination" are redirected there so handlers never test rd.
+struct FunctionalCoreState {
+    static constexpr int SINK_REGISTER = 32;
+
+    int coreId = 0;
+    int pc = 0;
+    std::array<int, 33> registers{};
+    uint64_t instructions = 0;      // instructions executed (halt is not counted)
+    FunctionalStop stop = FunctionalStop::RUNNING;
+};
+
+// Instruction-granularity interpreter over the decoded program. There are no
+// stage queues and no timing: each instruction runs to completion through a
+// threaded dispatch loop. Straight-line runs of the program (basic blocks,
+// ended by a branch or jal) are translated once, on first entry, and cached by
+// start PC; the budget and stop checks happen once per block, so inside a
+// block each handler jumps straight to the next. Memory is the simulator's
+// MemoryHierarchy; without warming it goes straight to main memory, with
+// warming every access takes the normal cache path so tags, LRU state and
+// dirty lines are what a detailed run would have left behind.
+class FunctionalEngine {
+public:
+    FunctionalEngine() = default;
+
+    void setProgram(std::shared_ptr<const std::vector<Instruction>> program);
+    void setMemoryHierarchy(std::shared_ptr<MemoryHierarchy> memHierarchy) {
+        memoryHierarchy = memHierarchy;
+    }
+
+    // Runs every core that is not halted or past the end of the program until
+    // each one stops. Barriers release once every core waits at one, as in the
+    // pipelined model. markerPC < 0 means no marker.
+    void run(std::vector<FunctionalCoreState> &cores, uint64_t maxInstructions,
+             int markerPC, bool warmCaches);
+
+private:
+    // Internal opcode set: the decoded Opcode plus the cases the pipelined core
+    // resolves at execute time (core-id branch, end of program, stop marker)
+    enum class Kind : uint8_t {
+        ADD, ADDI, SUB, SLT, MUL,
+        LW, LW_SPM, SW, SW_SPM,
+        BEQ, BNE, BLT, BGE, BEQ_CID, JAL, LA,
+        SYNC, INVLD1, HALT, NOP,
+        END, MARKER, LIMIT,
+        COUNT
+    };
+
+    struct Op {
+        Kind kind;
+        uint8_t rd;     // destination, or SINK_REGISTER
+        uint8_t rs1;
+        uint8_t rs2;
+        int immediate;  // also the core id of a core-id branch
+        int target;
+    };
+
+    std::shared_ptr<const std::vector<Instruction>> program;
+    std::shared_ptr<MemoryHierarchy> memoryHierarchy;
+    std::vector<Op> ops;            // program.size() + 1 entries; the last is END
+    int markerPC = -1;
+    Op markerSaved{};
+    int numCores = 0;
+
+    // Translation cache, indexed by the start PC of a block: how many
+    // instructions the block executes when it runs to its end (the closing
+    // branch counts, a closing sync/halt does not); -1 until first entered.
+    // Emptied whenever the program changes.
+    std::vector<int> blockLengths;
+
+    static Op translate(const Instruction &inst);
+    void placeMarker(int pc);
+    int translateBlock(int start);
+
+    template <bool WarmCaches>
+    FunctionalStop execute(FunctionalCoreState &core, uint64_t budget);
+};
+
+#endif // FUNCTIONAL_ENGINE_HPP
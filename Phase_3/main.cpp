@@ -1,7 +1,18 @@
 #include "pipelined_simulator.hpp"
+#include "sampled_simulation.hpp"
+#include "batch_runner.hpp"
+#include "design_sweep.hpp"
+#include "memory_trace.hpp"
+#include "sim_log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <string>
 #include <limits>
+#include <sstream>
 
 std::string trim(const std::string &s) {
     size_t first = s.find_first_not_of(" \t\n\r");
@@ -43,7 +54,213 @@ void configureInstructionLatencies(PipelinedSimulator& simulator) {
     }
 }
 
-int main() {
+// Runs the program from the start once per quantum, each time in a fresh
+// simulator configured like `configured`, and prints how far the cycle counts
+// of the relaxed runs drift from the exact run (quantum 1)
+void runQuantumDriftStudy(const PipelinedSimulator& configured, const std::string& cacheConfigFile,
+                          const std::string& programFile, std::vector<int> quanta) {
+    quanta.erase(std::remove(quanta.begin(), quanta.end(), 1), quanta.end());
+    quanta.insert(quanta.begin(), 1);
+
+    struct Result {
+        int quantum;
+        std::vector<int> cycles;
+        int totalCycles;
+        uint64_t instructions;
+        double seconds;
+    };
+    std::vector<Result> results;
+    for (int quantum : quanta) {
+        PipelinedSimulator simulator(configured.getNumCores(), configured.isForwardingEnabled());
+        simulator.setForwardingEnabled(configured.isForwardingEnabled());
+        for (const char* instruction : {"add", "addi", "sub", "slt", "mul"}) {
+            simulator.setInstructionLatency(instruction, configured.getInstructionLatency(instruction));
+        }
+        simulator.setStageCapacity(configured.getStageCapacity());
+        if (!cacheConfigFile.empty()) {
+            simulator.loadCacheConfig(cacheConfigFile);
+        }
+        simulator.loadProgramFromFile(programFile);
+        simulator.setHostThreads(configured.getHostThreads());
+        simulator.setQuantum(quantum);
+
+        auto start = std::chrono::steady_clock::now();
+        simulator.simulate();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<int> cycles = simulator.getCycleCounts();
+        results.push_back({quantum, cycles, *std::max_element(cycles.begin(), cycles.end()),
+                           simulator.getTotalInstructions(), seconds});
+    }
+
+    const Result& exact = results.front();
+    std::cout << "\n=== Quantum Drift (" << configured.getHostThreads() << " host thread(s)) ===\n";
+    std::cout << std::setw(8) << "Quantum" << std::setw(12) << "Cycles" << std::setw(10) << "Drift"
+              << std::setw(16) << "Max core drift" << std::setw(14) << "Instructions"
+              << std::setw(8) << "IPC" << std::setw(10) << "Wall s" << std::setw(9) << "Speedup" << "\n";
+    std::cout << std::fixed;
+    for (const Result& result : results) {
+        double drift = exact.totalCycles > 0
+                           ? (result.totalCycles - exact.totalCycles) * 100.0 / exact.totalCycles : 0.0;
+        double coreDrift = 0.0;
+        for (size_t i = 0; i < result.cycles.size(); i++) {
+            if (exact.cycles[i] > 0) {
+                coreDrift = std::max(coreDrift, std::abs(result.cycles[i] - exact.cycles[i]) * 100.0 /
+                                                exact.cycles[i]);
+            }
+        }
+        std::cout << std::setw(8) << result.quantum << std::setw(12) << result.totalCycles
+                  << std::setw(9) << std::setprecision(2) << drift << "%"
+                  << std::setw(15) << coreDrift << "%" << std::setw(14) << result.instructions
+                  << std::setw(8) << (result.totalCycles > 0
+                                          ? static_cast<double>(result.instructions) / result.totalCycles : 0.0)
+                  << std::setw(10) << std::setprecision(3) << result.seconds
+                  << std::setw(8) << std::setprecision(2)
+                  << (result.seconds > 0 ? exact.seconds / result.seconds : 0.0) << "x\n";
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
+
+// project --batch <job list> | --sweep <sweep file> | --replay <memory trace> --config <file>...
+//         [--threads <n>] [--csv <file>] [--json <file>]
+// Runs every job in the list (or every point of the sweep, or the recorded
+// memory trace once per cache configuration) without prompts and prints one
+// results table
+int runBatch(int argc, char* argv[]) {
+    std::string jobFile;
+    std::string sweepFile;
+    std::string replayFile;
+    std::vector<std::string> replayConfigs;
+    std::string csvFile;
+    std::string jsonFile;
+    int threads = 0;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + arg);
+            }
+            if (arg == "--batch") {
+                jobFile = argv[++i];
+            } else if (arg == "--sweep") {
+                sweepFile = argv[++i];
+            } else if (arg == "--replay") {
+                replayFile = argv[++i];
+            } else if (arg == "--config") {
+                replayConfigs.push_back(argv[++i]);
+            } else if (arg == "--threads") {
+                threads = std::stoi(argv[++i]);
+            } else if (arg == "--csv") {
+                csvFile = argv[++i];
+            } else if (arg == "--json") {
+                jsonFile = argv[++i];
+            } else {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+        if (jobFile.empty() + sweepFile.empty() + replayFile.empty() != 2) {
+            throw std::invalid_argument("Give one of a job list, a sweep file or a memory trace");
+        }
+        if (replayFile.empty() != replayConfigs.empty()) {
+            throw std::invalid_argument("A memory trace is replayed against one or more --config files");
+        }
+        if (!jsonFile.empty() && sweepFile.empty()) {
+            throw std::invalid_argument("JSON output is for sweeps");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\nUsage: " << argv[0] << " --batch <job list> | --sweep <sweep file>"
+                  << " | --replay <memory trace> --config <file>... [--threads <n>] [--csv <file>] [--json <file>]\n";
+        return 1;
+    }
+
+    auto writeFile = [](const std::string& name, auto&& write) {
+        std::ofstream out(name);
+        if (!out.is_open()) {
+            throw std::runtime_error("Could not open " + name);
+        }
+        write(out);
+        std::cout << "Results written to " << name << "\n";
+    };
+
+    try {
+        // Per-cycle chatter from many jobs at once is of no use; errors still show
+        SimLog::setLevel(LogLevel::OFF);
+        auto start = std::chrono::steady_clock::now();
+        bool anyFailed = false;
+        if (!sweepFile.empty()) {
+            DesignSweep sweep(sweepFile);
+            sweep.run(threads);
+            std::cout << "Sweep: " << sweep.getPoints().size() << " point(s), "
+                      << sweep.getDuplicateCount() << " duplicate(s) skipped\n\n";
+            sweep.printTable(std::cout);
+            for (const auto& point : sweep.getPoints()) {
+                anyFailed = anyFailed || !point.result.error.empty();
+            }
+            if (!csvFile.empty()) {
+                writeFile(csvFile, [&](std::ostream& out) { sweep.writeCsv(out); });
+            }
+            if (!jsonFile.empty()) {
+                writeFile(jsonFile, [&](std::ostream& out) { sweep.writeJson(out); });
+            }
+        } else if (!replayFile.empty()) {
+            MemoryTraceReplay replay(replayFile);
+            std::vector<std::pair<std::string, CacheConfig>> configs;
+            for (const auto& file : replayConfigs) {
+                std::ifstream in(file);
+                if (!in.is_open()) {
+                    throw std::runtime_error("Could not open cache configuration " + file);
+                }
+                CacheConfig config;
+                config.read(in);
+                configs.emplace_back(file, config);
+            }
+            std::cout << "Replaying " << replay.getEventCount() << " access(es) on " << replay.getNumCores()
+                      << " core(s) against " << configs.size() << " configuration(s)\n";
+            std::vector<MemoryTraceReplay::Result> results = replay.replayAll(configs, threads);
+            // Same number format as the statistics at the end of a run
+            std::cout << std::fixed << std::setprecision(2);
+            for (const auto& result : results) {
+                if (result.hierarchy) {
+                    std::cout << "\n--- " << result.name << " ---";
+                    result.hierarchy->printStatistics();
+                }
+            }
+            std::cout.unsetf(std::ios::floatfield);
+            std::cout << std::setprecision(6) << "\n";
+            replay.printTable(results, std::cout);
+            anyFailed = std::any_of(results.begin(), results.end(),
+                                    [](const MemoryTraceReplay::Result& result) { return !result.hierarchy; });
+            if (!csvFile.empty()) {
+                writeFile(csvFile, [&](std::ostream& out) { replay.writeCsv(results, out); });
+            }
+        } else {
+            std::vector<BatchJob> jobs = BatchRunner::loadJobs(jobFile);
+            BatchRunner runner(threads);
+            std::cout << "Running " << jobs.size() << " job(s) on " << runner.getThreadCount()
+                      << " host thread(s)\n\n";
+            std::vector<BatchResult> results = runner.run(jobs);
+            BatchRunner::printTable(results, std::cout);
+            anyFailed = std::any_of(results.begin(), results.end(),
+                                    [](const BatchResult& result) { return !result.error.empty(); });
+            if (!csvFile.empty()) {
+                writeFile(csvFile, [&](std::ostream& out) { BatchRunner::writeCsv(results, out); });
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "\nWall time: " << std::fixed << std::setprecision(3) << seconds << " s\n";
+        return anyFailed ? 1 : 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Batch failed: " << e.what() << "\n";
+        return 1;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        return runBatch(argc, argv);
+    }
+
     std::cout << "RISC-V Pipelined Multi-Core Simulator (Phase 3)\n\n";
     
     // Create simulator with 4 cores
@@ -79,6 +296,21 @@ int main() {
         std::cerr << "No file name provided. Exiting.\n";
         return 1;
     }
+
+    // Configure trace output
+    std::cout << "\nTrace output (none, all, or any of fetch,decode,exec,mem,cache,sync"
+              << " plus info/debug/trace; leave empty for info only): ";
+    std::string traceSpec;
+    std::getline(std::cin, traceSpec);
+    traceSpec = trim(traceSpec);
+
+    if (!traceSpec.empty()) {
+        try {
+            SimLog::configure(traceSpec);
+        } catch (const std::exception &e) {
+            std::cout << e.what() << ". Using default.\n";
+        }
+    }
     
     try {
         simulator.loadProgramFromFile(filename);
@@ -87,6 +319,162 @@ int main() {
         return 1;
     }
     
+    // Optionally estimate a long run from sampled detailed windows
+    std::cout << "\nSampled simulation ('every <instructions per core>' or 'at <n>,<n>,...';"
+              << " leave empty for a full run): ";
+    std::string samplingSpec;
+    std::getline(std::cin, samplingSpec);
+    samplingSpec = trim(samplingSpec);
+
+    if (!samplingSpec.empty()) {
+        SamplingOptions sampling;
+        try {
+            std::istringstream words(samplingSpec);
+            std::string mode, values;
+            words >> mode;
+            std::getline(words, values);
+            if (mode == "every") {
+                sampling.period = std::stoull(values);
+            } else if (mode == "at") {
+                std::istringstream points(values);
+                std::string point;
+                while (std::getline(points, point, ',')) {
+                    sampling.samplePoints.push_back(std::stoull(point));
+                }
+            } else {
+                throw std::invalid_argument("Unknown sampling mode '" + mode + "'");
+            }
+            SampledSimulation sampled(simulator, sampling);
+            sampled.run();
+            sampled.printReport();
+        } catch (const std::exception &e) {
+            std::cerr << "Sampled simulation failed: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // Optionally skip ahead functionally before the detailed run
+    std::cout << "\nFast-forward before the pipelined run (instructions per core and/or a label,"
+              << " add 'warm' to warm the caches; leave empty for none): ";
+    std::string fastForwardSpec;
+    std::getline(std::cin, fastForwardSpec);
+    fastForwardSpec = trim(fastForwardSpec);
+
+    // Optionally restore a checkpoint before the fast-forward and/or save one after it
+    std::cout << "\nCheckpoint ('restore <file>' before the fast-forward, 'save <file> [caches]' after it;"
+              << " leave empty for none): ";
+    std::string checkpointSpec;
+    std::getline(std::cin, checkpointSpec);
+    std::string restoreFile;
+    std::string saveFile;
+    bool saveCaches = false;
+    {
+        std::istringstream words(checkpointSpec);
+        std::string word;
+        while (words >> word) {
+            if (word == "restore") {
+                words >> restoreFile;
+            } else if (word == "save") {
+                words >> saveFile;
+            } else if (word == "caches") {
+                saveCaches = true;
+            } else {
+                std::cerr << "Unknown checkpoint option '" << word << "'\n";
+                return 1;
+            }
+        }
+    }
+    if (!restoreFile.empty()) {
+        try {
+            simulator.restoreCheckpoint(restoreFile);
+        } catch (const std::exception &e) {
+            std::cerr << "Checkpoint restore failed: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    if (!fastForwardSpec.empty()) {
+        FastForwardOptions options;
+        std::istringstream words(fastForwardSpec);
+        std::string word;
+        while (words >> word) {
+            if (word == "warm") {
+                options.warmCaches = true;
+            } else if (word.find_first_not_of("0123456789") == std::string::npos) {
+                options.maxInstructions = std::stoull(word);
+            } else {
+                options.stopLabel = word;
+            }
+        }
+        try {
+            simulator.printFastForwardSummary(simulator.fastForward(options));
+        } catch (const std::exception &e) {
+            std::cerr << "Fast-forward failed: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    if (!saveFile.empty()) {
+        try {
+            simulator.saveCheckpoint(saveFile, saveCaches);
+        } catch (const std::exception &e) {
+            std::cerr << "Checkpoint save failed: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    // Optionally clock the cores on several host threads (same results, less wall time)
+    std::cout << "\nHost threads for the pipelined run (leave empty for 1): ";
+    std::string threadsSpec;
+    std::getline(std::cin, threadsSpec);
+    threadsSpec = trim(threadsSpec);
+    if (!threadsSpec.empty()) {
+        try {
+            simulator.setHostThreads(std::stoi(threadsSpec));
+        } catch (const std::exception &e) {
+            std::cout << "Invalid thread count. Using 1.\n";
+        }
+    }
+
+    // Optionally relax the synchronization between host threads
+    std::cout << "\nSynchronization quantum in simulated cycles (1 = exact; 'drift <n>,<n>,...' runs the"
+              << " program from the start once per quantum and reports the drift; leave empty for 1): ";
+    std::string quantumSpec;
+    std::getline(std::cin, quantumSpec);
+    quantumSpec = trim(quantumSpec);
+    if (quantumSpec.rfind("drift", 0) == 0) {
+        std::vector<int> quanta;
+        std::istringstream values(quantumSpec.substr(5));
+        std::string value;
+        try {
+            while (std::getline(values, value, ',')) {
+                if (!trim(value).empty()) {
+                    quanta.push_back(std::stoi(value));
+                }
+            }
+            runQuantumDriftStudy(simulator, cacheConfigFile, filename, quanta);
+        } catch (const std::exception &e) {
+            std::cerr << "Drift study failed: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (!quantumSpec.empty()) {
+        try {
+            simulator.setQuantum(std::stoi(quantumSpec));
+        } catch (const std::exception &e) {
+            std::cout << "Invalid quantum. Using 1.\n";
+        }
+    }
+
+    // Optionally record the memory accesses for replay against other cache configurations
+    std::cout << "\nRecord a memory-access trace to (leave empty for none): ";
+    std::string memoryTraceFile;
+    std::getline(std::cin, memoryTraceFile);
+    memoryTraceFile = trim(memoryTraceFile);
+    simulator.setMemoryTraceFile(memoryTraceFile);
+
     // Run simulation
     std::cout << "\nRunning simulation...\n";
     simulator.run();
@@ -1,4 +1,7 @@
 #include "memory_hierarchy.hpp"
+#include "cache_path.hpp"
+#include "sim_log.hpp"
+#include "memory_trace.hpp"
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -10,79 +13,23 @@ MemoryHierarchy::MemoryHierarchy(int numCores, const std::string& configFile)
     loadConfiguration(configFile);
 }
 
+MemoryHierarchy::MemoryHierarchy(int numCores, const CacheConfig& config)
+    : numCores(numCores) {
+    setupMemoryHierarchy(config);
+}
+
 void MemoryHierarchy::loadConfiguration(const std::string& configFile) {
-    // Default configuration values
-    int l1iSize = 16 * 1024;     // 16KB
-    int l1dSize = 16 * 1024;     // 16KB
-    int l2Size = 256 * 1024;     // 256KB
-    int l1iBlockSize = 64;       // 64B
-    int l1dBlockSize = 64;       // 64B
-    int l2BlockSize = 64;        // 64B
-    int l1iAssoc = 2;            // 2-way
-    int l1dAssoc = 4;            // 4-way
-    int l2Assoc = 8;             // 8-way
-    int l1iLatency = 1;          // 1 cycle
-    int l1dLatency = 1;          // 1 cycle
-    int l2Latency = 10;          // 10 cycles
-    int memLatency = 100;        // 100 cycles
-    int spmSize = 16 * 1024;     // 16KB (same as L1D)
-    int spmLatency = 1;          // 1 cycle (same as L1D)
-    
-    ReplacementPolicy l1iPolicy = ReplacementPolicy::LRU;
-    ReplacementPolicy l1dPolicy = ReplacementPolicy::LRU;
-    ReplacementPolicy l2Policy = ReplacementPolicy::LRU;
+    CacheConfig config;
     
     // Try to load configuration from file
     try {
         std::ifstream file(configFile);
         if (file.is_open()) {
-            std::string line;
-            while (std::getline(file, line)) {
-                std::istringstream iss(line);
-                std::string key;
-                if (std::getline(iss, key, '=')) {
-                    std::string value;
-                    if (std::getline(iss, value)) {
-                        // Remove whitespace
-                        key.erase(0, key.find_first_not_of(" \t"));
-                        key.erase(key.find_last_not_of(" \t") + 1);
-                        value.erase(0, value.find_first_not_of(" \t"));
-                        value.erase(value.find_last_not_of(" \t") + 1);
-                        
-                        if (key == "L1I_SIZE") l1iSize = std::stoi(value);
-                        else if (key == "L1D_SIZE") l1dSize = std::stoi(value);
-                        else if (key == "L2_SIZE") l2Size = std::stoi(value);
-                        else if (key == "L1I_BLOCK_SIZE") l1iBlockSize = std::stoi(value);
-                        else if (key == "L1D_BLOCK_SIZE") l1dBlockSize = std::stoi(value);
-                        else if (key == "L2_BLOCK_SIZE") l2BlockSize = std::stoi(value);
-                        else if (key == "L1I_ASSOC") l1iAssoc = std::stoi(value);
-                        else if (key == "L1D_ASSOC") l1dAssoc = std::stoi(value);
-                        else if (key == "L2_ASSOC") l2Assoc = std::stoi(value);
-                        else if (key == "L1I_LATENCY") l1iLatency = std::stoi(value);
-                        else if (key == "L1D_LATENCY") l1dLatency = std::stoi(value);
-                        else if (key == "L2_LATENCY") l2Latency = std::stoi(value);
-                        else if (key == "MEM_LATENCY") memLatency = std::stoi(value);
-                        else if (key == "SPM_SIZE") spmSize = std::stoi(value);
-                        else if (key == "SPM_LATENCY") spmLatency = std::stoi(value);
-                        else if (key == "L1I_POLICY") {
-                            if (value == "LRU") l1iPolicy = ReplacementPolicy::LRU;
-                            else if (value == "FIFO") l1iPolicy = ReplacementPolicy::FIFO;
-                        }
-                        else if (key == "L1D_POLICY") {
-                            if (value == "LRU") l1dPolicy = ReplacementPolicy::LRU;
-                            else if (value == "FIFO") l1dPolicy = ReplacementPolicy::FIFO;
-                        }
-                        else if (key == "L2_POLICY") {
-                            if (value == "LRU") l2Policy = ReplacementPolicy::LRU;
-                            else if (value == "FIFO") l2Policy = ReplacementPolicy::FIFO;
-                        }
-                    }
-                }
-            }
+            config.read(file);
             file.close();
-            std::cout << "Cache configuration loaded from " << configFile << std::endl;
+            SIM_LOG(CACHE, INFO, "Cache configuration loaded from " << configFile << "\n");
         } else {
-            std::cout << "Cache configuration file " << configFile << " not found, using defaults" << std::endl;
+            SIM_LOG(CACHE, INFO, "Cache configuration file " << configFile << " not found, using defaults\n");
         }
     } catch (const std::exception& e) {
         std::cerr << "Error loading cache configuration: " << e.what() << std::endl;
@@ -90,12 +37,7 @@ void MemoryHierarchy::loadConfiguration(const std::string& configFile) {
     }
     
     // Setup the memory hierarchy with the loaded configuration
-    setupMemoryHierarchy(l1iSize, l1dSize, l2Size, 
-                       l1iBlockSize, l1dBlockSize, l2BlockSize,
-                       l1iAssoc, l1dAssoc, l2Assoc,
-                       l1iLatency, l1dLatency, l2Latency, memLatency,
-                       spmSize, spmLatency,
-                       l1iPolicy, l1dPolicy, l2Policy);
+    setupMemoryHierarchy(config);
 }
 
 void MemoryHierarchy::flushL1D(int coreId) {
@@ -103,7 +45,14 @@ void MemoryHierarchy::flushL1D(int coreId) {
 
     if (coreId < 0 || coreId >= numCores)
         throw std::out_of_range("Core ID out of range");
-    std::cout << "[MemoryHierarchy] flushL1D(" << coreId << ")\n";
+    SIM_LOG(CACHE, DEBUG, "[MemoryHierarchy] flushL1D(" << coreId << ")\n");
+    if (deferFlushes) {
+        deferredL1DFlushes[coreId] = true;
+        return;
+    }
+    if (traceRecorder) {
+        traceRecorder->record(MemoryTraceEvent::FLUSH_L1D, coreId, 0);
+    }
     // write back AND invalidate coreId’s L1D:
     l1DCaches[coreId]->writeBackAndInvalidate();
 }
@@ -111,6 +60,13 @@ void MemoryHierarchy::flushL1D(int coreId) {
 
 
 void MemoryHierarchy::flushCache() {
+    if (deferFlushes) {
+        deferredFullFlush = true;
+        return;
+    }
+    if (traceRecorder) {
+        traceRecorder->record(MemoryTraceEvent::FLUSH_ALL, -1, 0);
+    }
     // First: write back everything in each core’s L1 instruction and data caches
     for (auto& c : l1ICaches) c->writeBackAndInvalidate();
        for (auto& c : l1DCaches) c->writeBackAndInvalidate();
@@ -119,19 +75,52 @@ void MemoryHierarchy::flushCache() {
     l2Cache->flushCache();
 }
 
-void MemoryHierarchy::setupMemoryHierarchy(
-    int l1iSize, int l1dSize, int l2Size,
-    int l1iBlockSize, int l1dBlockSize, int l2BlockSize,
-    int l1iAssoc, int l1dAssoc, int l2Assoc,
-    int l1iLatency, int l1dLatency, int l2Latency, int memLatency,
-    int spmSize, int spmLatency,
-    ReplacementPolicy l1iPolicy, ReplacementPolicy l1dPolicy, ReplacementPolicy l2Policy) {
+void MemoryHierarchy::writeBackAndInvalidateAll() {
+    flushCache();
+    l2Cache->invalidateAll();
+}
+
+void MemoryHierarchy::setDeferFlushes(bool defer) {
+    if (!defer) {
+        applyDeferredFlushes();
+    }
+    deferFlushes = defer;
+    deferredL1DFlushes.assign(numCores, false);
+}
+
+void MemoryHierarchy::applyDeferredFlushes() {
+    bool wasDeferring = deferFlushes;
+    deferFlushes = false;
+    for (int c = 0; c < static_cast<int>(deferredL1DFlushes.size()); c++) {
+        if (deferredL1DFlushes[c]) {
+            deferredL1DFlushes[c] = false;
+            flushL1D(c);
+        }
+    }
+    if (deferredFullFlush) {
+        deferredFullFlush = false;
+        flushCache();
+    }
+    deferFlushes = wasDeferring;
+}
+
+void MemoryHierarchy::discardCaches() {
+    // Cache::invalidateAll clears the dirty bits too, so nothing is written back later
+    for (auto& c : l1ICaches) c->Cache::invalidateAll();
+    for (auto& c : l1DCaches) c->Cache::invalidateAll();
+    l2Cache->invalidateAll();
+}
+
+void MemoryHierarchy::setupMemoryHierarchy(const CacheConfig& config) {
+
+    tagOnly = config.tagOnly;
 
     // Create main memory (4MB for simplicity)
-    mainMemory = std::make_shared<MainMemory>(4 * 1024, memLatency);
+    mainMemory = std::make_shared<MainMemory>(4 * 1024, config.memLatency);
 
     // Create L2 cache (shared by all cores)
-    l2Cache = std::make_shared<L2Cache>(l2Size, l2BlockSize, l2Assoc, l2Latency, l2Policy);
+    l2Cache = std::make_shared<L2Cache>(config.l2Size, config.l2BlockSize, config.l2Assoc,
+                                        config.l2Latency, config.l2Policy, tagOnly);
 
     // Connect L2 to main memory
     auto memorySystem = std::make_unique<MemorySystem>(mainMemory);
@@ -140,29 +129,45 @@ void MemoryHierarchy::setupMemoryHierarchy(
     // Create L1 caches for each core
     for (int i = 0; i < numCores; i++) {
         // Create L1I cache
-        auto l1i = std::make_shared<L1ICache>(l1iSize, l1iBlockSize, l1iAssoc, l1iLatency, l1iPolicy);
+        auto l1i = std::make_shared<L1ICache>(config.l1iSize, config.l1iBlockSize, config.l1iAssoc,
+                                                config.l1iLatency, config.l1iPolicy, tagOnly);
 
         // Create L1D cache
-        auto l1d = std::make_shared<L1DCache>(l1dSize, l1dBlockSize, l1dAssoc, l1dLatency, l1dPolicy);
+        auto l1d = std::make_shared<L1DCache>(config.l1dSize, config.l1dBlockSize, config.l1dAssoc,
+                                                config.l1dLatency, config.l1dPolicy, tagOnly);
 
         // Create scratchpad memory
-        auto spm = std::make_shared<ScratchpadMemory>(spmSize, spmLatency);
+        auto spm = std::make_shared<ScratchpadMemory>(config.spmSize, config.spmLatency);
 
         // Connect L1 caches to L2
         // Use the CacheSystem constructor that accepts a shared_ptr to CacheSystem
         l1i->setNextLevelCache(std::make_unique<MemorySystem>(l2Cache));
         l1d->setNextLevelCache(std::make_unique<MemorySystem>(l2Cache));
 
+        // Accesses take a compiled path when both geometries have one,
+        // otherwise the caches' own read/write
+        auto fetchPath = makeStaticCachePath(*l1i, false, *l2Cache, *mainMemory);
+        auto dataPath = makeStaticCachePath(*l1d, true, *l2Cache, *mainMemory);
+        fetchPaths.push_back(fetchPath ? fetchPath.get() : l1i.get());
+        dataPaths.push_back(dataPath ? dataPath.get() : l1d.get());
+        if (fetchPath) staticPaths.push_back(std::move(fetchPath));
+        if (dataPath) staticPaths.push_back(std::move(dataPath));
+
         // Store the caches
         l1ICaches.push_back(l1i);
         l1DCaches.push_back(l1d);
         scratchpads.push_back(spm);
     }
 
-    std::cout << "Memory hierarchy initialized for " << numCores << " cores" << std::endl;
+    SIM_LOG(CACHE, INFO, "Memory hierarchy initialized for " << numCores << " cores"
+            << (tagOnly ? " (tag-only)" : "")
+            << ", " << staticPaths.size() << "/" << 2 * numCores << " L1 paths compiled\n");
 }
 void MemoryHierarchy::invalidateL1D(int coreID) {
     if (coreID >= 0 && coreID < numCores) {
+        if (traceRecorder) {
+            traceRecorder->record(MemoryTraceEvent::INVALIDATE_L1D, coreID, 0);
+        }
         l1DCaches[coreID]->invalidateAll();
     }
 }
@@ -182,17 +187,15 @@ std::pair<int, int32_t> MemoryHierarchy::fetchInstruction(int coreId, uint32_t a
     
     // Align address to word boundary
     address = address & ~0x3;
+    if (traceRecorder) {
+        traceRecorder->record(MemoryTraceEvent::FETCH, coreId, address);
+    }
     
     // Use L1I cache to fetch the instruction
-    auto [latency, data] = l1ICaches[coreId]->read(address, 4);
-    
-    // Convert bytes to 32-bit instruction
-    int32_t instruction = 0;
-    for (int i = 0; i < 4; i++) {
-        instruction |= (static_cast<int32_t>(data[i]) << (i * 8));
+    if (tagOnly) {
+        return {fetchPaths[coreId]->read(address, nullptr, 4), 0};
     }
-    
-    return {latency, instruction};
+    return fetchPaths[coreId]->readWord(address);
 }
 
 
@@ -203,17 +206,15 @@ std::pair<int, int32_t> MemoryHierarchy::loadWord(int coreId, uint32_t address)
     
     // Align address to word boundary
     address = address & ~0x3;
+    if (traceRecorder) {
+        traceRecorder->record(MemoryTraceEvent::LOAD, coreId, address);
+    }
     
     // Use L1D cache to load the word
-    auto [latency, data] = l1DCaches[coreId]->read(address, 4);
-    
-    // Convert bytes to 32-bit word
-    int32_t word = 0;
-    for (int i = 0; i < 4; i++) {
-        word |= (static_cast<int32_t>(data[i]) << (i * 8));
+    if (tagOnly) {
+        return {dataPaths[coreId]->read(address, nullptr, 4), mainMemory->getWord(address)};
     }
-    
-    return {latency, word};
+    return dataPaths[coreId]->readWord(address);
 }
 
 int MemoryHierarchy::storeWord(int coreId, uint32_t address, int32_t value) {
@@ -223,15 +224,16 @@ int MemoryHierarchy::storeWord(int coreId, uint32_t address, int32_t value) {
     
     // Align address to word boundary
     address = address & ~0x3;
-    
-    // Convert 32-bit word to bytes
-    std::vector<uint8_t> data(4);
-    for (int i = 0; i < 4; i++) {
-        data[i] = (value >> (i * 8)) & 0xFF;
+    if (traceRecorder) {
+        traceRecorder->record(MemoryTraceEvent::STORE, coreId, address);
     }
     
     // Use L1D cache to store the word
-    return l1DCaches[coreId]->write(address, data);
+    if (tagOnly) {
+        mainMemory->setWord(address, value);
+        return dataPaths[coreId]->write(address, nullptr, 4);
+    }
+    return dataPaths[coreId]->writeWord(address, value);
 }
 
 std::pair<int, int32_t> MemoryHierarchy::loadWordFromSPM(int coreId, uint32_t address) {
@@ -241,6 +243,9 @@ std::pair<int, int32_t> MemoryHierarchy::loadWordFromSPM(int coreId, uint32_t ad
     
     // Align address to word boundary
     address = address & ~0x3;
+    if (traceRecorder) {
+        traceRecorder->record(MemoryTraceEvent::SPM_LOAD, coreId, address);
+    }
     
     // Load from scratchpad memory
     int32_t value = scratchpads[coreId]->loadWord(address);
@@ -255,6 +260,9 @@ int MemoryHierarchy::storeWordToSPM(int coreId, uint32_t address, int32_t value)
     
     // Align address to word boundary
     address = address & ~0x3;
+    if (traceRecorder) {
+        traceRecorder->record(MemoryTraceEvent::SPM_STORE, coreId, address);
+    }
     
     // Store to scratchpad memory
     scratchpads[coreId]->storeWord(address, value);
@@ -5,10 +5,11 @@
 #include <vector>
 #include <mutex>
 #include "cache.hpp"
+#include "cache_config.hpp"
 #include "cache_system.hpp"
 #include <atomic>
 
-
+class MemoryTraceWriter;
 
 class MemoryHierarchy {
 private:
@@ -17,11 +18,33 @@ private:
     std::vector<std::shared_ptr<L1ICache>> l1ICaches;
     std::vector<std::shared_ptr<L1DCache>> l1DCaches;
     std::vector<std::shared_ptr<ScratchpadMemory>> scratchpads;
+    // Per core, what fetches and data accesses go through: a StaticCachePath
+    // (cache_path.hpp) over the caches above when their geometry has one,
+    // else the L1 itself. staticPaths owns the former.
+    std::vector<CacheSystem*> fetchPaths;
+    std::vector<CacheSystem*> dataPaths;
+    std::vector<std::unique_ptr<CacheSystem>> staticPaths;
     int numCores;
-    
+    // CACHE_MODE=TAG_ONLY: the caches only time accesses and count hits;
+    // loads, stores and fetches take their values from main memory
+    bool tagOnly = false;
+
+    // Relaxed parallel mode: flushes are queued here and applied at the next quantum boundary
+    bool deferFlushes = false;
+    std::vector<bool> deferredL1DFlushes;
+    bool deferredFullFlush = false;
+
+    // Every access and flush is recorded here while set (see memory_trace.hpp)
+    MemoryTraceWriter* traceRecorder = nullptr;
+
 public:
+    // Reads the configuration file; defaults for a missing file or key
     MemoryHierarchy(int numCores, const std::string& configFile);
+    // Throws std::invalid_argument for a configuration a cache cannot be built from
+    MemoryHierarchy(int numCores, const CacheConfig& config);
     std::shared_ptr<MainMemory> getMainMemory() const { return mainMemory; }
+    // Latency and the word at address. The program is pre-decoded and not kept
+    // in memory, so callers only use the latency; tag-only mode returns 0.
     std::pair<int, int32_t> fetchInstruction(int coreId, uint32_t address);
 
     void waitForAllWriteBacksToComplete();
@@ -87,6 +110,9 @@ public:
     }
     void resetStatistics() ;
     void flushCache();
+    /// Write every dirty line back to main memory and invalidate all caches,
+    /// L2 included, so main memory alone holds the current data.
+    void writeBackAndInvalidateAll();
     /// Return a const reference to the entire memory array
     const std::vector<uint8_t>& getRawMemory() const {
               return mainMemory->getRawMemory();
@@ -96,6 +122,20 @@ public:
     std::shared_ptr<ScratchpadMemory> getSPM(int coreId) {
         return scratchpads[coreId];
     }
+    const std::shared_ptr<L1ICache>& getL1I(int coreId) const { return l1ICaches[coreId]; }
+    const std::shared_ptr<L1DCache>& getL1D(int coreId) const { return l1DCaches[coreId]; }
+    const std::shared_ptr<L2Cache>& getL2() const { return l2Cache; }
+    int getNumCores() const { return numCores; }
+    bool isTagOnly() const { return tagOnly; }
+    /// Drop every cache line without writing anything back (checkpoint restore).
+    void discardCaches();
+    /// While set, flushL1D and flushCache only record the request; the relaxed
+    /// parallel engine applies them between quanta, when no core is running.
+    void setDeferFlushes(bool defer);
+    void applyDeferredFlushes();
+    /// Records every access, flush and invalidation into writer until reset to
+    /// nullptr. Deferred flushes are recorded when they are applied.
+    void setTraceRecorder(MemoryTraceWriter* writer) { traceRecorder = writer; }
 
 private:
 
@@ -105,12 +145,7 @@ private:
 
 
 
-    void setupMemoryHierarchy(int l1iSize, int l1dSize, int l2Size,
-                              int l1iBlockSize, int l1dBlockSize, int l2BlockSize,
-                              int l1iAssoc, int l1dAssoc, int l2Assoc,
-                              int l1iLatency, int l1dLatency, int l2Latency, int memLatency,
-                              int spmSize, int spmLatency,
-                              ReplacementPolicy l1iPolicy, ReplacementPolicy l1dPolicy, ReplacementPolicy l2Policy);
+    void setupMemoryHierarchy(const CacheConfig& config);
 
 
 };
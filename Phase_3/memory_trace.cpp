@@ -0,0 +1,230 @@
+#include "memory_trace.hpp"
+#include "memory_hierarchy.hpp"
+#include "work_stealing_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+    MemoryHierarchy::CacheStats totals(const MemoryHierarchy &memory, MemoryHierarchy::CacheType type) {
+        if (type == MemoryHierarchy::CacheType::L2) {
+            return memory.getCacheStats(type);
+        }
+        MemoryHierarchy::CacheStats sum{0, 0, 0};
+        for (int core = 0; core < memory.getNumCores(); core++) {
+            MemoryHierarchy::CacheStats stats = memory.getCacheStats(type, core);
+            sum.accesses += stats.accesses;
+            sum.hits += stats.hits;
+            sum.misses += stats.misses;
+        }
+        return sum;
+    }
+
+    double hitRate(const MemoryHierarchy &memory, MemoryHierarchy::CacheType type) {
+        MemoryHierarchy::CacheStats stats = totals(memory, type);
+        return stats.accesses > 0 ? static_cast<double>(stats.hits) / stats.accesses : 0.0;
+    }
+}
+
+MemoryTraceWriter::MemoryTraceWriter(const std::string &path, int numCores, std::function<int(int)> cycleOf)
+    : cycleOf(std::move(cycleOf)) {
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open memory trace file: " + path);
+    }
+    buffer.reserve(BUFFER_EVENTS);
+
+    uint32_t cores = numCores;
+    out.write(MAGIC, sizeof(MAGIC));
+    out.write(reinterpret_cast<const char *>(&VERSION), sizeof(VERSION));
+    out.write(reinterpret_cast<const char *>(&cores), sizeof(cores));
+}
+
+MemoryTraceWriter::~MemoryTraceWriter() {
+    // An unfinished trace (e.g. the run threw) still gets its buffered events
+    if (!finished) {
+        flush();
+    }
+}
+
+void MemoryTraceWriter::record(MemoryTraceEvent::Kind kind, int coreId, uint32_t address) {
+    bool access = kind <= MemoryTraceEvent::SPM_STORE;
+    int32_t cycle = access ? cycleOf(coreId) : 0;
+    std::lock_guard<std::mutex> guard(lock);
+    if (finished) {
+        return;
+    }
+    if (access) {
+        lastCycle = std::max(lastCycle, cycle);
+    } else {
+        cycle = lastCycle;
+    }
+    buffer.push_back(MemoryTraceEvent{address, cycle, static_cast<uint8_t>(kind),
+                                      static_cast<uint8_t>(coreId < 0 ? MemoryTraceEvent::ALL_CORES : coreId),
+                                      {0, 0}});
+    events++;
+    if (buffer.size() >= BUFFER_EVENTS) {
+        flush();
+    }
+}
+
+void MemoryTraceWriter::finish() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (finished) {
+        return;
+    }
+    buffer.push_back(MemoryTraceEvent{0, lastCycle, MemoryTraceEvent::END, MemoryTraceEvent::ALL_CORES, {0, 0}});
+    flush();
+    out.flush();
+    finished = true;
+}
+
+void MemoryTraceWriter::flush() {
+    if (!buffer.empty()) {
+        out.write(reinterpret_cast<const char *>(buffer.data()),
+                  static_cast<std::streamsize>(buffer.size() * sizeof(MemoryTraceEvent)));
+        buffer.clear();
+    }
+}
+
+MemoryTraceReplay::MemoryTraceReplay(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Could not open memory trace file: " + path);
+    }
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t cores = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(&version), sizeof(version));
+    in.read(reinterpret_cast<char *>(&cores), sizeof(cores));
+    if (!in || std::memcmp(magic, MemoryTraceWriter::MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error(path + " is not a memory trace");
+    }
+    if (version != MemoryTraceWriter::VERSION) {
+        throw std::runtime_error(path + " has unsupported memory trace version " + std::to_string(version));
+    }
+    if (cores < 1 || cores > 16) {
+        throw std::runtime_error(path + " records an invalid core count");
+    }
+    numCores = static_cast<int>(cores);
+
+    in.seekg(0, std::ios::end);
+    std::streamoff size = static_cast<std::streamoff>(in.tellg()) - 12;
+    in.seekg(12);
+    events.resize(static_cast<size_t>(size) / sizeof(MemoryTraceEvent));
+    in.read(reinterpret_cast<char *>(events.data()),
+            static_cast<std::streamsize>(events.size() * sizeof(MemoryTraceEvent)));
+    if (events.empty() || events.back().kind != MemoryTraceEvent::END) {
+        throw std::runtime_error(path + " has no end record, the run did not finish");
+    }
+    events.pop_back();
+    for (const auto &event: events) {
+        if (event.kind >= MemoryTraceEvent::END ||
+            (event.coreId >= numCores && event.coreId != MemoryTraceEvent::ALL_CORES)) {
+            throw std::runtime_error(path + " is corrupt");
+        }
+    }
+}
+
+MemoryTraceReplay::Result MemoryTraceReplay::replay(const std::string &name, const CacheConfig &config) const {
+    Result result;
+    result.name = name;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        // The trace holds no values, so the caches need not carry any; hit and
+        // miss counts do not depend on the mode
+        CacheConfig timing = config;
+        timing.tagOnly = true;
+        auto hierarchy = std::make_shared<MemoryHierarchy>(numCores, timing);
+        MemoryHierarchy &memory = *hierarchy;
+        for (const auto &event: events) {
+            switch (event.kind) {
+                case MemoryTraceEvent::FETCH:
+                    memory.fetchInstruction(event.coreId, event.address);
+                    break;
+                case MemoryTraceEvent::LOAD:
+                    memory.loadWord(event.coreId, event.address);
+                    break;
+                case MemoryTraceEvent::STORE:
+                    memory.storeWord(event.coreId, event.address, 0);
+                    break;
+                case MemoryTraceEvent::SPM_LOAD:
+                    memory.loadWordFromSPM(event.coreId, event.address);
+                    break;
+                case MemoryTraceEvent::SPM_STORE:
+                    memory.storeWordToSPM(event.coreId, event.address, 0);
+                    break;
+                case MemoryTraceEvent::FLUSH_L1D:
+                    memory.flushL1D(event.coreId);
+                    break;
+                case MemoryTraceEvent::INVALIDATE_L1D:
+                    memory.invalidateL1D(event.coreId);
+                    break;
+                case MemoryTraceEvent::FLUSH_ALL:
+                    memory.flushCache();
+                    break;
+            }
+        }
+        result.hierarchy = hierarchy;
+    } catch (const std::exception &e) {
+        result.error = e.what();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::vector<MemoryTraceReplay::Result> MemoryTraceReplay::replayAll(
+        const std::vector<std::pair<std::string, CacheConfig>> &configs, int threads) const {
+    std::vector<Result> results(configs.size());
+    WorkStealingPool pool(threads > 0 ? threads : WorkStealingPool::hostThreads());
+    pool.run(configs.size(), [&](size_t i) { results[i] = replay(configs[i].first, configs[i].second); });
+    return results;
+}
+
+void MemoryTraceReplay::printTable(const std::vector<Result> &results, std::ostream &out) const {
+    using Type = MemoryHierarchy::CacheType;
+    out << std::left << std::setw(24) << "Configuration" << std::right << std::setw(9) << "L1I hit"
+        << std::setw(9) << "L1D hit" << std::setw(9) << "L2 hit" << std::setw(12) << "L2 misses"
+        << std::setw(10) << "Wall s" << std::setw(14) << "Accesses/s" << "\n";
+    out << std::fixed;
+    for (const auto &result: results) {
+        out << std::left << std::setw(24) << result.name << std::right;
+        if (!result.hierarchy) {
+            out << "  failed: " << result.error << "\n";
+            continue;
+        }
+        const MemoryHierarchy &memory = *result.hierarchy;
+        out << std::setprecision(2)
+            << std::setw(8) << hitRate(memory, Type::L1I) * 100.0 << "%"
+            << std::setw(8) << hitRate(memory, Type::L1D) * 100.0 << "%"
+            << std::setw(8) << hitRate(memory, Type::L2) * 100.0 << "%"
+            << std::setw(12) << totals(memory, Type::L2).misses
+            << std::setw(10) << std::setprecision(3) << result.seconds
+            << std::setw(14) << std::setprecision(0)
+            << (result.seconds > 0 ? events.size() / result.seconds : 0.0) << "\n";
+    }
+    out.unsetf(std::ios::floatfield);
+    out << std::setprecision(6);
+}
+
+void MemoryTraceReplay::writeCsv(const std::vector<Result> &results, std::ostream &out) const {
+    using Type = MemoryHierarchy::CacheType;
+    out << "config,status,accesses,l1i_hit_rate,l1d_hit_rate,l2_hit_rate,l2_misses,seconds,error\n";
+    for (const auto &result: results) {
+        out << result.name;
+        if (!result.hierarchy) {
+            std::string error = result.error;
+            std::replace(error.begin(), error.end(), ',', ';');
+            out << ",failed,,,,,,," << error << "\n";
+            continue;
+        }
+        const MemoryHierarchy &memory = *result.hierarchy;
+        out << ",ok," << events.size() << "," << hitRate(memory, Type::L1I) << ","
+            << hitRate(memory, Type::L1D) << "," << hitRate(memory, Type::L2) << ","
+            << totals(memory, Type::L2).misses << "," << result.seconds << ",\n";
+    }
+}
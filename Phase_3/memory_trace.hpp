@@ -0,0 +1,111 @@
+#ifndef MEMORY_TRACE_HPP
+#define MEMORY_TRACE_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "cache_config.hpp"
+
+class MemoryHierarchy;
+
+// Binary memory-access trace: every access a run makes through the
+// MemoryHierarchy, in the order the hierarchy saw them, so it can be replayed
+// against other cache configurations without the pipeline. Values are stored
+// in host byte order, like the pipeline trace.
+//
+//   header : "MTRC", uint32 version, uint32 numCores
+//   event  : uint32 address, int32 cycle, uint8 kind, uint8 coreId, 2 pad bytes
+//   end    : kind END, cycle = last cycle seen
+//
+// Stored values are not recorded: hits, misses and latencies do not depend on
+// them. Flushes and invalidations carry the cycle of the access before them.
+struct MemoryTraceEvent {
+    enum Kind : uint8_t {
+        FETCH, LOAD, STORE, SPM_LOAD, SPM_STORE,
+        FLUSH_L1D, INVALIDATE_L1D, FLUSH_ALL,
+        END
+    };
+    static constexpr uint8_t ALL_CORES = 0xFF;
+
+    uint32_t address;
+    int32_t cycle;
+    uint8_t kind;
+    uint8_t coreId;
+    uint8_t reserved[2];
+};
+static_assert(sizeof(MemoryTraceEvent) == 12, "MemoryTraceEvent is written to disk as-is");
+
+class MemoryTraceWriter {
+public:
+    static constexpr char MAGIC[4] = {'M', 'T', 'R', 'C'};
+    static constexpr uint32_t VERSION = 1;
+
+    // cycleOf(coreId) gives a core's current cycle; it is only asked about the
+    // core making the access. Throws std::runtime_error if the file cannot be
+    // opened.
+    MemoryTraceWriter(const std::string& path, int numCores, std::function<int(int)> cycleOf);
+    ~MemoryTraceWriter();
+
+    // Safe to call from several threads (the parallel engine's L1 hits)
+    void record(MemoryTraceEvent::Kind kind, int coreId, uint32_t address);
+
+    // Appends the end event and flushes. Further records are ignored.
+    void finish();
+
+    uint64_t getEventCount() const { return events; }
+
+private:
+    static constexpr size_t BUFFER_EVENTS = 4096;
+
+    std::ofstream out;
+    std::function<int(int)> cycleOf;
+    std::mutex lock;
+    std::vector<MemoryTraceEvent> buffer;
+    int32_t lastCycle = 0;
+    uint64_t events = 0;
+    bool finished = false;
+
+    void flush();
+};
+
+// Feeds a recorded trace into fresh MemoryHierarchy instances, one per cache
+// configuration, at memory-system speed. The hierarchies start cold, so the
+// statistics match the recorded run when it started from cold caches.
+class MemoryTraceReplay {
+public:
+    struct Result {
+        std::string name;
+        std::shared_ptr<MemoryHierarchy> hierarchy;   // null when the configuration failed
+        std::string error;
+        double seconds = 0.0;
+    };
+
+    // Loads the whole trace; throws std::runtime_error for a bad file
+    explicit MemoryTraceReplay(const std::string& path);
+
+    int getNumCores() const { return numCores; }
+    size_t getEventCount() const { return events.size(); }
+
+    // Never throws: a configuration whose caches cannot be built reports an error
+    Result replay(const std::string& name, const CacheConfig& config) const;
+
+    // One replay per configuration, in parallel (0 threads: one per host CPU);
+    // results in the order given
+    std::vector<Result> replayAll(const std::vector<std::pair<std::string, CacheConfig>>& configs,
+                                  int threads = 0) const;
+
+    // Hit rates per configuration (L1 caches summed over cores) and replay speed
+    void printTable(const std::vector<Result>& results, std::ostream& out) const;
+    void writeCsv(const std::vector<Result>& results, std::ostream& out) const;
+
+private:
+    int numCores = 0;
+    std::vector<MemoryTraceEvent> events;
+};
+
+#endif // MEMORY_TRACE_HPP
@@ -0,0 +1,150 @@
+#include "parallel_engine.hpp"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include "centralized_fetch.hpp"
+#include "sim_log.hpp"
+
+ParallelEngine::ParallelEngine(std::vector<PipelinedCore> &cores, const std::vector<std::string> &program,
+                               int threads, int quantum)
+    : cores(cores),
+      program(program),
+      threads(std::max(1, std::min<int>(threads, cores.size()))),
+      quantum(std::max(1, quantum)),
+      memoryHierarchy(cores.empty() ? nullptr : cores.front().getMemoryHierarchy()),
+      barrier(this->threads),
+      turn(cores.size(), this->quantum > 1 ? SharedAccessTurn::Mode::LOCKED : SharedAccessTurn::Mode::ORDERED),
+      active(cores.size(), 1),
+      finished(cores.size(), 0),
+      idleAhead(cores.size(), 0),
+      logs(cores.size()) {
+}
+
+void ParallelEngine::beginCycle() {
+    if (quantum > 1) {
+        return;
+    }
+    std::vector<int> order;
+    bool l1dHitsPrivate = true;
+    for (size_t i = 0; i < cores.size(); i++) {
+        if (active[i]) {
+            order.push_back(static_cast<int>(i));
+            l1dHitsPrivate = l1dHitsPrivate && !cores[i].retiresSharedThisCycle();
+        }
+    }
+    turn.beginCycle(order, l1dHitsPrivate);
+}
+
+void ParallelEngine::endCycle() {
+    bool allCoresHalted = true;
+    for (size_t i = 0; i < cores.size(); i++) {
+        if (!active[i]) {
+            continue;
+        }
+        if (logs[i].tellp() > 0) {
+            std::cout << logs[i].str();
+            logs[i].str("");
+        }
+        if (finished[i]) {
+            active[i] = 0;
+        } else {
+            allCoresHalted = false;
+        }
+    }
+    if (quantum > 1) {
+        if (memoryHierarchy) {
+            memoryHierarchy->applyDeferredFlushes();
+        }
+    } else {
+        centralizedFetch(cores, program);
+    }
+
+    if (allCoresHalted) {
+        stop = true;
+        return;
+    }
+    if (quantum == 1) {
+        auto running = [this](size_t i) { return active[i] != 0; };
+        int idleForAll = idleCyclesForAll(cores, program, idleAhead, running);
+        for (size_t i = 0; i < cores.size() && idleForAll > 0; i++) {
+            if (running(i)) {
+                idleAhead[i] -= idleForAll;
+            }
+        }
+    }
+    beginCycle();
+}
+
+void ParallelEngine::runQuantum(int coreId) {
+    PipelinedCore &core = cores[coreId];
+    for (int cycle = 0; cycle < quantum && !finished[coreId]; cycle++) {
+        core.clockCycle();
+        turn.leave(coreId);
+        finished[coreId] = core.isHalted() || core.isPipelineEmpty();
+
+        // An L1I hit stays private; a miss goes on to L2
+        if (memoryHierarchy && !memoryHierarchy->getL1I(coreId)->contains(core.getPC() * 4)) {
+            turn.enter(coreId);
+        }
+        fetchForCore(core, program);
+        turn.leave(coreId);
+    }
+}
+
+void ParallelEngine::worker(int thread) {
+    while (true) {
+        for (size_t i = thread; i < cores.size(); i += threads) {
+            if (!active[i]) {
+                continue;
+            }
+            SimLog::setStream(&logs[i]);
+            if (quantum > 1) {
+                runQuantum(static_cast<int>(i));
+            } else if (idleAhead[i] > 0) {
+                idleAhead[i]--;
+                turn.leave(static_cast<int>(i));
+            } else {
+                int idle = cores[i].skipIdleCycles();
+                if (idle > 0) {
+                    idleAhead[i] = idle - 1;
+                } else {
+                    cores[i].clockCycle();
+                }
+                turn.leave(static_cast<int>(i));    // a halted core returns before taking part
+                finished[i] = cores[i].isHalted() || cores[i].isPipelineEmpty();
+            }
+        }
+        SimLog::setStream(nullptr);
+        barrier.arriveAndWait([this] { endCycle(); });
+        if (stop) {
+            return;
+        }
+    }
+}
+
+void ParallelEngine::run() {
+    for (auto &core: cores) {
+        core.setSharedAccessTurn(&turn);
+    }
+    if (quantum > 1 && memoryHierarchy) {
+        memoryHierarchy->setDeferFlushes(true);
+    }
+    centralizedFetch(cores, program);
+    beginCycle();
+
+    std::vector<std::thread> helpers;
+    for (int t = 1; t < threads; t++) {
+        helpers.emplace_back(&ParallelEngine::worker, this, t);
+    }
+    worker(0);
+    for (auto &helper: helpers) {
+        helper.join();
+    }
+
+    if (quantum > 1 && memoryHierarchy) {
+        memoryHierarchy->setDeferFlushes(false);
+    }
+    for (auto &core: cores) {
+        core.setSharedAccessTurn(nullptr);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef PARALLEL_ENGINE_HPP
+#define PARALLEL_ENGINE_HPP
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "pipelined_core.hpp"
+#include "spin_barrier.hpp"
+
+// Clocks the pipelined cores on several host threads. Core i is clocked by
+// thread i % threads, and each core's trace messages are buffered and printed
+// in core order.
+//
+// With a quantum of 1 (exact) the results are identical to the serial loop in
+// PipelinedSimulator::run. Threads meet once per simulated cycle at a spin
+// barrier; the last to arrive does the serial part (centralized fetch, halt
+// bookkeeping, trace output) while the others wait. Within a cycle, accesses
+// to shared state are ordered by core id through a SharedAccessTurn.
+//
+// With a larger quantum (relaxed) every core runs that many cycles on its own,
+// fetching for itself, before the threads meet. Shared state (L2, main memory,
+// the sync barrier) is taken under a lock in whatever order the cores get
+// there, and L1 flushes requested by a barrier or a halt are held back and
+// applied at the quantum boundary. Cores drift apart by up to a quantum, so
+// timing is approximate and, with several threads, not repeatable.
+class ParallelEngine {
+public:
+    ParallelEngine(std::vector<PipelinedCore>& cores, const std::vector<std::string>& program,
+                   int threads, int quantum = 1);
+
+    // Runs until every core has halted or drained, as the serial loop does
+    void run();
+
+    int getThreadCount() const { return threads; }
+
+private:
+    std::vector<PipelinedCore>& cores;
+    const std::vector<std::string>& program;
+    int threads;
+    int quantum;
+    std::shared_ptr<MemoryHierarchy> memoryHierarchy;
+
+    SpinBarrier barrier;
+    SharedAccessTurn turn;
+    std::vector<uint8_t> active;        // clocked this cycle (quantum)
+    std::vector<uint8_t> finished;      // halted or drained after this cycle (quantum)
+    std::vector<int> idleAhead;         // cycles already accounted for by skipIdleCycles
+    std::vector<std::ostringstream> logs;
+    bool stop = false;
+
+    void worker(int thread);
+    void runQuantum(int coreId);
+    void beginCycle();
+    void endCycle();                    // serial; runs on the last thread to arrive
+};
+
+#endif // PARALLEL_ENGINE_HPP
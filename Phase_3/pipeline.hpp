@@ -6,6 +6,10 @@
 #include <vector>
 #include <queue>
 #include <memory>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
 
 enum class PipelineStage {
     FETCH,
@@ -16,80 +20,159 @@ enum class PipelineStage {
     COMPLETED
 };
 
+// Dense opcode numbering used to index the per-opcode handler and latency tables
+enum class Opcode : uint8_t {
+    ADD,
+    ADDI,
+    SUB,
+    SLT,
+    MUL,
+    LW,
+    LW_SPM,
+    SW,
+    SW_SPM,
+    BEQ,
+    BNE,
+    BLT,
+    BGE,
+    JAL,
+    LA,
+    SYNC,
+    INVLD1,
+    HALT,
+    UNKNOWN,
+    COUNT
+};
+
+constexpr int NUM_OPCODES = static_cast<int>(Opcode::COUNT);
+
+inline const char* opcodeName(Opcode op) {
+    static const char* const names[NUM_OPCODES + 1] = {
+        "add", "addi", "sub", "slt", "mul", "lw", "lw_spm", "sw", "sw_spm",
+        "beq", "bne", "blt", "bge", "jal", "la", "sync", "invld1", "halt",
+        "unknown", "unknown"
+    };
+    return names[static_cast<int>(op)];
+}
+
+inline Opcode opcodeFromString(const std::string& name) {
+    static const std::unordered_map<std::string, Opcode> opcodes = {
+        {"add", Opcode::ADD},       {"addi", Opcode::ADDI},     {"sub", Opcode::SUB},
+        {"slt", Opcode::SLT},       {"mul", Opcode::MUL},       {"lw", Opcode::LW},
+        {"lw_spm", Opcode::LW_SPM}, {"sw", Opcode::SW},         {"sw_spm", Opcode::SW_SPM},
+        {"beq", Opcode::BEQ},       {"bne", Opcode::BNE},       {"blt", Opcode::BLT},
+        {"bge", Opcode::BGE},       {"jal", Opcode::JAL},       {"la", Opcode::LA},
+        {"sync", Opcode::SYNC},     {"invld1", Opcode::INVLD1}, {"halt", Opcode::HALT}
+    };
+    auto it = opcodes.find(name);
+    return it != opcodes.end() ? it->second : Opcode::UNKNOWN;
+}
 
+// In-flight instruction record. It is kept trivially copyable and within one
+// cache line so that moving it between stage queues is a plain memcpy; the
+// source text lives in the simulator's program table, indexed by pc.
 struct Instruction {
     int id; // New unique ID field
+    int pc = -1;            // index of the source line in the program table
 
-    std::string raw;
-    std::string opcode;
     int rd = -1;
     int rs1 = -1;
     int rs2 = -1;
-    int rs1Value = 0;
-    int rs2Value = 0;
     int immediate = 0;
+    int targetPC = -1;
+    int coreId = -1;
+    int cyclesInExecute = 0;
+    int executeLatency = 1;
+    int resultValue = 0;
+    int memoryLatency = 0;
+
+    Opcode op = Opcode::UNKNOWN;
     bool isBranch = false;
     bool isJump = false;
     bool isMemory = false;
     bool isArithmetic = false;
-    bool takeBranch = false;
-    int targetPC = -1;
-    int coreId = -1;
     bool shouldExecute = true;
-    std::string label;
     bool useCID = false;
-    PipelineStage stage = PipelineStage::FETCH;
-    int cyclesInExecute = 0;
-    int executeLatency = 1;
-    int resultValue = 0;
     bool hasResult = false;
-    
+    bool isLabel = false;   // source line still carries a "label:" prefix
+
     // Cache and SPM related fields
     bool isSPM = false;
     bool isSync = false;
-    int memoryLatency = 0;
     bool waitingForMemory = false;
     bool isInvalidateL1D=false;
 };
 
+static_assert(std::is_trivially_copyable<Instruction>::value,
+              "Instruction must stay trivially copyable");
+static_assert(sizeof(Instruction) <= 64, "Instruction should fit in one cache line");
+
 class Pipeline {
 private:
     std::vector<Instruction> stages;
-    std::unordered_map<std::string, int> instructionLatencies;
+    std::array<int, NUM_OPCODES> instructionLatencies;
     bool forwardingEnabled;
     int stallCount;
     int instructionCount;
     int memoryStallCycles;
+    int stageCapacity;      // max entries a stage queue may hold before upstream stalls
     
 public:
+    static constexpr int NUM_STAGES = 5;
+    static constexpr int DEFAULT_STAGE_CAPACITY = 2;
+
     Pipeline(bool enableForwarding = true) 
-        : forwardingEnabled(enableForwarding), stallCount(0), instructionCount(0), memoryStallCycles(0) {
+        : forwardingEnabled(enableForwarding), stallCount(0), instructionCount(0), memoryStallCycles(0),
+          stageCapacity(DEFAULT_STAGE_CAPACITY) {
         // Initialize pipeline stages
-        stages.resize(5); // 5 stages: F, D, E, M, W
+        stages.resize(NUM_STAGES); // 5 stages: F, D, E, M, W
         
         // Default latencies
-        instructionLatencies["add"] = 1;
-        instructionLatencies["addi"] = 1;
-        instructionLatencies["sub"] = 1;
-        instructionLatencies["slt"] = 1;
-        instructionLatencies["mul"] = 3;
+        instructionLatencies.fill(1);
+        instructionLatencies[static_cast<int>(Opcode::MUL)] = 3;
     }
     
     void setInstructionLatency(const std::string& instruction, int latency) {
-        instructionLatencies[instruction] = latency;
+        Opcode op = opcodeFromString(instruction);
+        if (op != Opcode::UNKNOWN) {
+            instructionLatencies[static_cast<int>(op)] = latency;
+        }
     }
     
-    int getInstructionLatency(const std::string& instruction) const {
-        auto it = instructionLatencies.find(instruction);
-        if (it != instructionLatencies.end()) {
-            return it->second;
-        }
-        return 1; // Default latency
+    int getInstructionLatency(Opcode op) const {
+        return instructionLatencies[static_cast<int>(op)];
     }
     
     void setForwardingEnabled(bool enabled) {
         forwardingEnabled = enabled;
     }
+
+    // The hazard checks only look at the execute queue, so with deeper queues
+    // a dependent instruction can read a stale register, and with 1 the
+    // program ends after a few cycles. Until the checks cover every stage,
+    // only the default is accepted; throws std::invalid_argument otherwise.
+    static void checkStageCapacity(int capacity) {
+        if (capacity != DEFAULT_STAGE_CAPACITY) {
+            throw std::invalid_argument("Stage capacity must be " + std::to_string(DEFAULT_STAGE_CAPACITY) +
+                                        " (got " + std::to_string(capacity) + ")");
+        }
+    }
+
+    void setStageCapacity(int capacity) {
+        checkStageCapacity(capacity);
+        stageCapacity = capacity;
+    }
+
+    int getStageCapacity() const {
+        return stageCapacity;
+    }
+
+    // Storage size for each stage queue. Some paths (branches, SYNC, stalled
+    // memory ops) push past the occupancy limit, so size every queue to hold
+    // everything that can be in flight across all stages at once.
+    int getQueueStorageCapacity() const {
+        return NUM_STAGES * stageCapacity;
+    }
     
     bool isForwardingEnabled() const {
         return forwardingEnabled;
@@ -130,7 +213,7 @@ public:
         instructionCount = 0;
         memoryStallCycles = 0;
         stages.clear();
-        stages.resize(5);
+        stages.resize(NUM_STAGES);
     }
 };
 
@@ -0,0 +1,182 @@
+#include "pipeline_trace.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+
+PipelineTraceWriter::~PipelineTraceWriter() {
+    // An unfinished trace (e.g. the run threw) still gets its buffered events
+    if (out.is_open() && !finished) {
+        flush();
+    }
+}
+
+void PipelineTraceWriter::open(const std::string &tracePath, int coreId) {
+    if (out.is_open()) {
+        out.close();
+    }
+    out.open(tracePath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open pipeline trace file: " + tracePath);
+    }
+    path = tracePath;
+    finished = false;
+    buffer.clear();
+    buffer.reserve(BUFFER_EVENTS);
+
+    int32_t id = coreId;
+    out.write(MAGIC, sizeof(MAGIC));
+    out.write(reinterpret_cast<const char *>(&VERSION), sizeof(VERSION));
+    out.write(reinterpret_cast<const char *>(&id), sizeof(id));
+}
+
+void PipelineTraceWriter::record(int instId, int cycle, char stage) {
+    if (!out.is_open() || finished) {
+        return;
+    }
+    buffer.push_back(TraceEvent{instId, cycle, stage, {0, 0, 0}});
+    if (buffer.size() >= BUFFER_EVENTS) {
+        flush();
+    }
+}
+
+void PipelineTraceWriter::finish(int cycleCount) {
+    if (!out.is_open() || finished) {
+        return;
+    }
+    buffer.push_back(TraceEvent{TRACE_END_ID, cycleCount, 0, {0, 0, 0}});
+    flush();
+    out.flush();
+    finished = true;
+}
+
+void PipelineTraceWriter::flush() {
+    if (!buffer.empty()) {
+        out.write(reinterpret_cast<const char *>(buffer.data()),
+                  static_cast<std::streamsize>(buffer.size() * sizeof(TraceEvent)));
+        buffer.clear();
+    }
+}
+
+namespace {
+    // Everything the converter needs about one instruction's row. Only the events
+    // inside the requested window are kept; the rest of the row is implied.
+    struct TraceRow {
+        int firstColumn = -1;
+        int lastColumn = -1;
+        char lastStage = 0;
+        std::vector<TraceEvent> windowEvents;
+    };
+}
+
+void PipelineTraceConverter::toCsv(const std::string &tracePath, const std::string &csvPath,
+                                   int firstCycle, int lastCycle) {
+    if (firstCycle < 1 || lastCycle < firstCycle) {
+        throw std::invalid_argument("Invalid cycle window");
+    }
+
+    std::ifstream in(tracePath, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Could not open pipeline trace file: " + tracePath);
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    int32_t coreId = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(&version), sizeof(version));
+    in.read(reinterpret_cast<char *>(&coreId), sizeof(coreId));
+    if (!in || std::memcmp(magic, PipelineTraceWriter::MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a pipeline trace file: " + tracePath);
+    }
+    if (version != PipelineTraceWriter::VERSION) {
+        throw std::runtime_error("Unsupported pipeline trace version " + std::to_string(version));
+    }
+
+    // CSV columns are 0-based cycles; "CycleN" is column N-1
+    const int windowStart = firstCycle - 1;
+    const int windowEnd = lastCycle - 1;
+
+    std::map<int, TraceRow> rows;
+    int cycleCount = -1;
+    int maxColumn = -1;
+    std::vector<TraceEvent> chunk(4096);
+
+    while (cycleCount < 0) {
+        in.read(reinterpret_cast<char *>(chunk.data()),
+                static_cast<std::streamsize>(chunk.size() * sizeof(TraceEvent)));
+        size_t count = static_cast<size_t>(in.gcount()) / sizeof(TraceEvent);
+        if (count == 0) {
+            break;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            const TraceEvent &event = chunk[i];
+            if (event.instId == PipelineTraceWriter::TRACE_END_ID) {
+                cycleCount = event.cycle;
+                break;
+            }
+
+            TraceRow &row = rows[event.instId];
+            if (row.firstColumn < 0) {
+                row.firstColumn = event.cycle;
+            }
+            row.lastColumn = event.cycle;
+            row.lastStage = event.stage;
+            maxColumn = std::max(maxColumn, event.cycle);
+            if (event.cycle >= windowStart && event.cycle <= windowEnd) {
+                row.windowEvents.push_back(event);
+            }
+        }
+    }
+
+    if (cycleCount < 0) {
+        std::cerr << "Warning: " << tracePath << " has no end record, the run did not finish\n";
+        cycleCount = maxColumn + 1;
+    }
+
+    std::ofstream outFile(csvPath);
+    if (!outFile.is_open()) {
+        throw std::runtime_error("Could not open CSV file: " + csvPath);
+    }
+
+    outFile << "InstrID";
+    for (int cycle = windowStart; cycle <= cycleCount && cycle <= windowEnd; cycle++) {
+        outFile << ",Cycle" << (cycle + 1);
+    }
+    outFile << "\n";
+
+    int normalizedId = 0;
+    for (const auto &entry: rows) {
+        const TraceRow &row = entry.second;
+        normalizedId++;
+
+        // An instruction that never reached W keeps stalling until the end of the run
+        int paddedLength = row.lastColumn + 1;
+        if (row.lastStage != 'W') {
+            paddedLength = std::max(paddedLength, cycleCount);
+        }
+        int rowLength = std::max(paddedLength, cycleCount);
+
+        if (row.firstColumn > windowEnd || paddedLength <= windowStart) {
+            continue;
+        }
+
+        outFile << normalizedId;
+        auto nextEvent = row.windowEvents.begin();
+        for (int column = windowStart; column < rowLength && column <= windowEnd; column++) {
+            outFile << ",";
+            if (column < row.firstColumn || column >= paddedLength) {
+                continue;
+            }
+            if (nextEvent != row.windowEvents.end() && nextEvent->cycle == column) {
+                outFile << nextEvent->stage;
+                ++nextEvent;
+            } else {
+                outFile << "S";
+            }
+        }
+        outFile << "\n";
+    }
+}
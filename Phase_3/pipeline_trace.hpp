@@ -0,0 +1,70 @@
+#ifndef PIPELINE_TRACE_HPP
+#define PIPELINE_TRACE_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Binary pipeline trace: a small header followed by one fixed-size event per
+// recorded stage cell and a terminating end event. Values are stored in host
+// byte order; traces are meant to be converted on the machine that wrote them.
+//
+//   header : "PTRC", uint32 version, int32 coreId
+//   event  : int32 instId, int32 cycle (CSV column, 0-based), char stage, 3 pad bytes
+//   end    : instId = TRACE_END_ID, cycle = final cycle count
+//
+// Cells that are not events are implied: the gap between two events of the same
+// instruction and the tail of an instruction that never reached W are "S", the
+// rest is blank.
+struct TraceEvent {
+    int32_t instId;
+    int32_t cycle;
+    char stage;
+    char reserved[3];
+};
+static_assert(sizeof(TraceEvent) == 12, "TraceEvent is written to disk as-is");
+
+class PipelineTraceWriter {
+public:
+    static constexpr char MAGIC[4] = {'P', 'T', 'R', 'C'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr int32_t TRACE_END_ID = -1;
+
+    PipelineTraceWriter() = default;
+    PipelineTraceWriter(PipelineTraceWriter&&) = default;
+    PipelineTraceWriter& operator=(PipelineTraceWriter&&) = default;
+    ~PipelineTraceWriter();
+
+    // Truncates the file and writes the header; throws std::runtime_error on failure
+    void open(const std::string& path, int coreId);
+    bool isOpen() const { return out.is_open(); }
+    const std::string& getPath() const { return path; }
+
+    void record(int instId, int cycle, char stage);
+
+    // Appends the end event and flushes. Further records are ignored.
+    void finish(int cycleCount);
+
+private:
+    static constexpr size_t BUFFER_EVENTS = 4096;
+
+    std::ofstream out;
+    std::string path;
+    std::vector<TraceEvent> buffer;
+    bool finished = false;
+
+    void flush();
+};
+
+class PipelineTraceConverter {
+public:
+    // Regenerates the pipeline_coreN.csv layout from a trace, limited to the
+    // 1-based cycle columns [firstCycle, lastCycle]. The full range reproduces
+    // the CSV the simulator used to build in memory. Throws std::runtime_error.
+    static void toCsv(const std::string& tracePath, const std::string& csvPath,
+                      int firstCycle = 1, int lastCycle = std::numeric_limits<int>::max());
+};
+
+#endif // PIPELINE_TRACE_HPP
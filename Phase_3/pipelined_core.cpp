@@ -1,5 +1,5 @@
 #include "pipelined_core.hpp"
-#include "instruction_parser.hpp"
+#include "sim_log.hpp"
 #include <stdexcept>
 #include <algorithm>
 #include <iostream>
@@ -8,6 +8,8 @@
 #include <iomanip>
 #include <vector>
 #include <unordered_map>
+#include <cstring>
+#include <array>
 
 PipelinedCore::PipelinedCore(int id, bool enableForwarding)
     : coreId(id)
@@ -17,91 +19,138 @@ PipelinedCore::PipelinedCore(int id, bool enableForwarding)
       , cycleCount(0)
       , stallCount(0)
       , instructionCount(0)
+      , cycleStallOccurred(false)
       , halted(false) {
     registers[31] = coreId;
+    traceFile = "pipeline_core" + std::to_string(coreId) + ".trace";
+    setStageCapacity(pipeline.getStageCapacity());
+}
+
+void PipelinedCore::setStageCapacity(int capacity) {
+    pipeline.setStageCapacity(capacity);
+    size_t storage = pipeline.getQueueStorageCapacity();
+    fetchQueue.setCapacity(storage);
+    decodeQueue.setCapacity(storage);
+    executeQueue.setCapacity(storage);
+    memoryQueue.setCapacity(storage);
+    writebackQueue.setCapacity(storage);
 }
 
 void PipelinedCore::reset() {
     std::fill(registers.begin(), registers.end(), 0);
     registers[31] = coreId;
     pc = 0;
-    labels.clear();
 
     fetchQueue.clear();
     decodeQueue.clear();
     executeQueue.clear();
     memoryQueue.clear();
     writebackQueue.clear();
-    pendingWrites.clear();
+    scoreboard.reset();
 
     cycleCount = 0;
+    stallPadCycle = -1;
+    openTraceRows.clear();
+    if (traceFile.empty()) {
+        trace = PipelineTraceWriter();
+    } else {
+        trace.open(traceFile, coreId);
+    }
     stallCount = 0;
     instructionCount = 0;
     pipeline.reset();
 }
 
+void PipelinedCore::loadArchitecturalState(int newPC, const std::vector<int> &values, bool isHalted) {
+    for (int i = 0; i < NUM_REGISTERS && i < static_cast<int>(values.size()); i++) {
+        registers[i] = values[i];
+    }
+    registers[0] = 0;
+    registers[31] = coreId;
+    pc = newPC;
+    halted = isHalted;
+
+    fetchQueue.clear();
+    decodeQueue.clear();
+    executeQueue.clear();
+    memoryQueue.clear();
+    writebackQueue.clear();
+    scoreboard.reset();
+    fetchWaitCycles = 0;
+    fetchInProgress = false;
+    clearPendingFetch();
+}
+
 int PipelinedCore::getForwardedValue(int reg) const {
-    if (!pipeline.isForwardingEnabled()) {
+    if (!pipeline.isForwardingEnabled() || !scoreboard.hasForwardedValue(reg)) {
         return getRegister(reg);
     }
-    for (const auto &inst: writebackQueue) {
-        if (inst.hasResult && inst.rd == reg)
-            return inst.resultValue;
-    }
-    for (const auto &inst: memoryQueue) {
-        if (inst.hasResult && inst.rd == reg)
-            return inst.resultValue;
-    }
-    for (const auto &inst: executeQueue) {
-        if (inst.hasResult && inst.rd == reg)
-            return inst.resultValue;
+    return scoreboard.forwardedValue[reg];
+}
+
+void PipelinedCore::scoreboardIssue(const Instruction &inst) {
+    if (inst.rd > 0 && inst.rd < NUM_REGISTERS) {
+        scoreboard.pendingWriters[inst.rd]++;
     }
-    return getRegister(reg);
 }
 
-void PipelinedCore::exportPipelineRecord(const std::string &filename) const {
-    std::ofstream outFile(filename);
-    if (!outFile.is_open()) {
-        std::cerr << "Error opening file " << filename << std::endl;
+void PipelinedCore::scoreboardResult(const Instruction &inst) {
+    if (!inst.hasResult || !RegisterScoreboard::isValidRegister(inst.rd)) {
         return;
     }
-
-    outFile << "InstrID";
-    for (int cycle = 0; cycle <= cycleCount; cycle++) {
-        outFile << ",Cycle" << (cycle+1);
+    // Instruction ids follow program order, so the smallest id is the oldest producer
+    int &producer = scoreboard.producerId[inst.rd];
+    if (producer < 0 || inst.id <= producer) {
+        producer = inst.id;
+        scoreboard.forwardedValue[inst.rd] = inst.resultValue;
     }
-    outFile << "\n";
+}
 
-    std::vector<int> keys;
-    for (const auto &pair: pipelineRecord) {
-        keys.push_back(pair.first);
+void PipelinedCore::scoreboardRetire(const Instruction &inst) {
+    if (inst.rd > 0 && inst.rd < NUM_REGISTERS) {
+        scoreboard.pendingWriters[inst.rd]--;
+    }
+    if (RegisterScoreboard::isValidRegister(inst.rd) && scoreboard.producerId[inst.rd] == inst.id) {
+        // The forwarding source left the pipeline; fall back to the next oldest
+        // in-flight producer. This only happens once per producing instruction.
+        int reg = inst.rd;
+        scoreboard.producerId[reg] = -1;
+        for (const auto *queue : {&writebackQueue, &memoryQueue, &executeQueue}) {
+            for (const auto &other : *queue) {
+                if (other.hasResult && other.rd == reg && other.id != inst.id) {
+                    scoreboard.producerId[reg] = other.id;
+                    scoreboard.forwardedValue[reg] = other.resultValue;
+                    return;
+                }
+            }
+        }
     }
-    std::sort(keys.begin(), keys.end());
+}
 
-    std::unordered_map<int, int> idMapping;
-    int normalizedId = 1;
-    for (int id: keys) {
-        idMapping[id] = normalizedId++;
+void PipelinedCore::flushQueue(RingBuffer<Instruction> &queue) {
+    while (!queue.empty()) {
+        Instruction inst = queue.front();
+        queue.pop_front();
+        scoreboardRetire(inst);
     }
+}
 
-    for (auto &pair: const_cast<std::unordered_map<int, std::vector<std::string>> &>(pipelineRecord)) {
-        while (pair.second.size() < static_cast<size_t>(cycleCount)) {
-            pair.second.push_back("");
-        }
-    }
+void PipelinedCore::finishTrace() {
+    trace.finish(cycleCount);
+}
 
-    for (int id: keys) {
-        outFile << idMapping[id];
-        auto it = pipelineRecord.find(id);
-        if (it != pipelineRecord.end()) {
-            for (const auto &stage: it->second) {
-                outFile << "," << stage;
-            }
-        }
-        outFile << "\n";
+void PipelinedCore::exportPipelineRecord(const std::string &filename) const {
+    if (trace.getPath().empty()) {
+        std::cerr << "No pipeline trace recorded for core " << coreId << std::endl;
+        return;
     }
 
-    outFile.close();
+    try {
+        PipelineTraceConverter::toCsv(trace.getPath(), filename);
+    } catch (const std::exception &e) {
+        std::cerr << "Error exporting pipeline record: " << e.what() << std::endl;
+        return;
+    }
     std::cout << "Pipeline record exported to " << filename << std::endl;
 }
 
@@ -109,24 +158,43 @@ bool PipelinedCore::isPipelineStalled() const {
     if (cycleStallOccurred)
         return true;
 
-    if (fetchQueue.size() >= 2)
+    const size_t limit = pipeline.getStageCapacity();
+    if (fetchQueue.size() >= limit)
         return true;
-    if (decodeQueue.size() >= 2)
+    if (decodeQueue.size() >= limit)
         return true;
-    if (memoryQueue.size() >= 2)
+    if (memoryQueue.size() >= limit)
         return true;
-    if (writebackQueue.size() >= 2)
+    if (writebackQueue.size() >= limit)
         return true;
 
     return false;
 }
 
+// Every cycle an instruction that has not reached W yet gets an "S" cell unless
+// something was already recorded for it that cycle. Those cells are not written;
+// the trace converter fills the gaps, so only the column of each real cell matters.
 void PipelinedCore::recordStageForInstruction(int instId, const std::string &stage) {
-    if (pipelineRecord.find(instId) == pipelineRecord.end()) {
-        pipelineRecord[instId] = std::vector<std::string>(cycleCount, "");
+    char letter = stage.empty() ? ' ' : stage[0];
+    int column = cycleCount;
+
+    auto it = openTraceRows.find(instId);
+    if (it != openTraceRows.end()) {
+        column = it->second.nextColumn;
+        if (it->second.lastStage != 'W') {
+            column = std::max(column, stallPadCycle + 1);
+        }
     }
 
-    pipelineRecord[instId].push_back(stage);
+    trace.record(instId, column, letter);
+
+    if (letter == 'W') {
+        if (it != openTraceRows.end()) openTraceRows.erase(it);
+    } else if (it != openTraceRows.end()) {
+        it->second = OpenTraceRow{column + 1, letter};
+    } else {
+        openTraceRows.emplace(instId, OpenTraceRow{column + 1, letter});
+    }
 }
 
 int PipelinedCore::getRegister(int index) const {
@@ -166,7 +234,7 @@ void PipelinedCore::decode(bool &shouldStall) {
         return;
     }
 
-    if (decodeQueue.size() >= 2) {
+    if (decodeQueue.size() >= static_cast<size_t>(pipeline.getStageCapacity())) {
         const FetchEntry &entry = fetchQueue.front();
 
         recordStageForInstruction(entry.fetchId, "S");
@@ -192,13 +260,15 @@ void PipelinedCore::decode(bool &shouldStall) {
     //     // fall through: pop fetchQueue & push a “nop” sync inst into the pipeline
     // }
 
-    if (entry.rawInst.find(':') != std::string::npos) {
+    const Instruction &decoded = (*decodedProgram)[entry.pc];
+    if (decoded.isLabel) {
         incrementPC();
         fetchQueue.pop_front();
         return;
     }
 
-    Instruction inst = InstructionParser::parseInstruction(entry.rawInst, coreId);
+    Instruction inst = decoded;
+    inst.coreId = coreId;
 
     if (!pipeline.isForwardingEnabled() && !operandsReadyForUse(inst)) {
         recordStageForInstruction(entry.fetchId, "S");
@@ -218,137 +288,76 @@ void PipelinedCore::decode(bool &shouldStall) {
     //         inst.shouldExecute = false;
     //     }
     // }
-    if (inst.opcode == "beq" && inst.rs1 == 31) {
+    if (inst.op == Opcode::BEQ && inst.rs1 == 31) {
         // only CU inst.rs2 should ever execute it:
         if (coreId != inst.rs2) inst.shouldExecute = false;
     }
 
     if (inst.isArithmetic) {
-        inst.executeLatency = pipeline.getInstructionLatency(inst.opcode);
+        inst.executeLatency = pipeline.getInstructionLatency(inst.op);
     }
 
     decodeQueue.push_back(inst);
+    scoreboardIssue(inst);
     recordStageForInstruction(inst.id, "D");
 }
 
-bool PipelinedCore::isRegisterInUse(int reg) const {
-    if (reg == 0) {
-        return false;
-    }
-
-    for (const auto &inst: decodeQueue) {
-        if (inst.rd == reg && inst.shouldExecute) {
-            return true;
-        }
-    }
-
-    for (const auto &inst: executeQueue) {
-        if (inst.rd == reg && inst.shouldExecute) {
-            return true;
-        }
-    }
-
-    for (const auto &inst: memoryQueue) {
-        if (inst.rd == reg && inst.shouldExecute) {
-            return true;
-        }
-    }
-
-    for (const auto &inst: writebackQueue) {
-        if (inst.rd == reg && inst.shouldExecute) {
-            return true;
-        }
-    }
-
-    return false;
-}
-
 bool PipelinedCore::operandsReadyForUse(const Instruction &inst) const {
     for (int reg: {inst.rs1, inst.rs2}) {
         if (reg == 0) continue;
 
-        auto it = registerAvailableCycle.find(reg);
-        if (it != registerAvailableCycle.end()) {
-            if (cycleCount < it->second) {
-                return false;
-            }
+        if (!scoreboard.isReadyAt(reg, cycleCount)) {
+            return false;
         }
     }
     return true;
 }
 
+// Only consulted with forwarding disabled: the consumer waits until no other
+// in-flight instruction still has to write one of its source registers.
 bool PipelinedCore::operandsAvailable(const Instruction &consumer) const {
-    static int callCount = 0;
-    callCount++;
-
-    if (!pipeline.isForwardingEnabled()) {
-        if (pendingWrites.find(consumer.rs1) != pendingWrites.end() ||
-            pendingWrites.find(consumer.rs2) != pendingWrites.end()) {
-            return false;
-        }
-
-        auto checkQueue = [this, &consumer](const std::deque<Instruction> &q, const std::string &qName) -> bool {
-            for (const auto &inst: q) {
-                if (inst.id == consumer.id)
-                    continue;
-                if (inst.rd < 0)
-                    continue;
-                if (inst.rd == 0)
-                    continue;
-                if ((consumer.rs1 != 0 && inst.rd == consumer.rs1) ||
-                    (consumer.rs2 != 0 && inst.rd == consumer.rs2)) {
-                    std::cout << "  BLOCKING: inst id=" << inst.id
-                            << " (rd=" << inst.rd << ") in " << qName
-                            << " blocks consumer (id=" << consumer.id << ")" << std::endl;
-                    return false;
-                }
-            }
-            return true;
-        };
-
-        if (!checkQueue(decodeQueue, "decodeQueue"))
-            return false;
-        if (!checkQueue(executeQueue, "executeQueue"))
-            return false;
-        if (!checkQueue(memoryQueue, "memoryQueue"))
-            return false;
-        if (!checkQueue(writebackQueue, "writebackQueue"))
-            return false;
-
-        return true;
+    if (scoreboard.hasPendingWrite(consumer.rs1) || scoreboard.hasPendingWrite(consumer.rs2)) {
+        return false;
     }
-    else {
-        auto checkQueueForward = [this, &consumer](const std::deque<Instruction> &q, const std::string &qName) -> bool {
-            for (const auto &inst: q) {
-                if (inst.id == consumer.id)
-                    continue;
-                if (inst.rd < 0)
-                    continue;
-                if (inst.rd == 0) continue;
-                if (!inst.hasResult && ((consumer.rs1 != 0 && inst.rd == consumer.rs1) ||
-                                        (consumer.rs2 != 0 && inst.rd == consumer.rs2))) {
-                    std::cout << "  BLOCKING: inst id=" << inst.id
-                            << " (rd=" << inst.rd << ") in " << qName
-                            << " blocks consumer (id=" << consumer.id << ")" << std::endl;
-                    return false;
-                }
-            }
-            return true;
-        };
 
-        if (!checkQueueForward(decodeQueue, "decodeQueue"))
-            return false;
-        if (!checkQueueForward(executeQueue, "executeQueue"))
-            return false;
-        if (!checkQueueForward(memoryQueue, "memoryQueue"))
-            return false;
-        if (!checkQueueForward(writebackQueue, "writebackQueue"))
-            return false;
+    for (int reg: {consumer.rs1, consumer.rs2}) {
+        if (reg <= 0 || reg >= NUM_REGISTERS) continue;
 
-        return true;
+        int writers = scoreboard.pendingWriters[reg];
+        if (consumer.rd == reg) writers--;   // the consumer itself is in flight
+        if (writers > 0) {
+            SIM_LOG(EXEC, DEBUG, "  BLOCKING: x" << reg << " has " << writers
+                    << " pending writer(s), consumer id=" << consumer.id << "\n");
+            return false;
+        }
     }
+    return true;
 }
 
+const std::array<PipelinedCore::ExecHandler, NUM_OPCODES> PipelinedCore::execHandlers = [] {
+    std::array<ExecHandler, NUM_OPCODES> table;
+    table.fill(&PipelinedCore::execDefault);
+    table[static_cast<int>(Opcode::ADD)]    = &PipelinedCore::execArithmetic;
+    table[static_cast<int>(Opcode::ADDI)]   = &PipelinedCore::execArithmetic;
+    table[static_cast<int>(Opcode::SUB)]    = &PipelinedCore::execArithmetic;
+    table[static_cast<int>(Opcode::SLT)]    = &PipelinedCore::execArithmetic;
+    table[static_cast<int>(Opcode::MUL)]    = &PipelinedCore::execArithmetic;
+    table[static_cast<int>(Opcode::LW)]     = &PipelinedCore::execLoad;
+    table[static_cast<int>(Opcode::LW_SPM)] = &PipelinedCore::execLoad;
+    table[static_cast<int>(Opcode::SW)]     = &PipelinedCore::execStore;
+    table[static_cast<int>(Opcode::SW_SPM)] = &PipelinedCore::execStore;
+    table[static_cast<int>(Opcode::BEQ)]    = &PipelinedCore::execBranch;
+    table[static_cast<int>(Opcode::BNE)]    = &PipelinedCore::execBranch;
+    table[static_cast<int>(Opcode::BLT)]    = &PipelinedCore::execBranch;
+    table[static_cast<int>(Opcode::BGE)]    = &PipelinedCore::execBranch;
+    table[static_cast<int>(Opcode::JAL)]    = &PipelinedCore::execJump;
+    table[static_cast<int>(Opcode::LA)]     = &PipelinedCore::execLoadAddress;
+    table[static_cast<int>(Opcode::SYNC)]   = &PipelinedCore::execSync;
+    table[static_cast<int>(Opcode::INVLD1)] = &PipelinedCore::execInvalidate;
+    table[static_cast<int>(Opcode::HALT)]   = &PipelinedCore::execHalt;
+    return table;
+}();
+
 void PipelinedCore::execute(bool &shouldStall) {
     shouldStall = false;
     Instruction inst;
@@ -376,247 +385,226 @@ void PipelinedCore::execute(bool &shouldStall) {
 
     recordStageForInstruction(inst.id, "E");
 
-    std::cout << "[Core " << coreId << "] Executing instruction: "
-            << inst.opcode << " (rs1: " << inst.rs1
-            << ", rs2: " << inst.rs2 << ", rd: " << inst.rd << ")\n";
-    std::cout << "   Clock cycle : " << cycleCount << std::endl;
+    SIM_LOG(EXEC, DEBUG, "[Core " << coreId << "] Executing instruction: "
+            << opcodeName(inst.op) << " (rs1: " << inst.rs1
+            << ", rs2: " << inst.rs2 << ", rd: " << inst.rd << ")\n");
+    SIM_LOG(EXEC, DEBUG, "   Clock cycle : " << cycleCount << "\n");
 
     if (!inst.shouldExecute) {
-        std::cout << "[Core " << coreId << "] Skipping instruction (shouldExecute = false)\n";
+        SIM_LOG(EXEC, DEBUG, "[Core " << coreId << "] Skipping instruction (shouldExecute = false)\n");
         memoryQueue.push_back(inst);
         return;
     }
-    if (inst.opcode == "halt") {
-        std::cout << "[Core " << coreId << "] Executing HALT, flushing pipeline\n";
-        fetchQueue.clear();
-        decodeQueue.clear();
-        executeQueue.clear();
-        memoryQueue.clear();
-        halted=true;
-        recordStageForInstruction(inst.id, "M");
+
+    // Handlers return false when they have already routed the instruction
+    if (!(this->*execHandlers[static_cast<int>(inst.op)])(inst, fromDecode, shouldStall)) {
         return;
     }
-    // Handle SYNC instruction
-    std::cout << "[Core " << coreId << "] About to check SYNC execution\n";
 
-    // if (inst.isSync) {
-    //     std::cout << "[Core " << coreId << "] Executing SYNC instruction\n";
-    //
-    //     // Call sync mechanism
-    //     if (syncMechanism) {
-    //         syncMechanism->syncCore(coreId);
-    //     }
-    //
-    //     // Move to memory stage
-    //     memoryQueue.push_back(inst);
-    //     return;
-    // }
-        if (inst.isSync) {
-                // Phase 1: mark arrival, stall until all cores have arrived
-                std::cout << "[Core " << coreId << "] Arrived at SYNC\n";
-              syncMechanism->arrive(coreId);
-
-                if (!syncMechanism->canProceed(coreId)) {
-                        // still waiting for the last core → spin here
-                        recordStageForInstruction(inst.id, "S");
-                        shouldStall = true;
-                    cycleStallOccurred = true;
-                    executeQueue.push_front(inst);
-                        return;
-                  }
-
-                // Phase 1 complete: push the SYNC into MEM so it can retire
-                std::cout << "[Core " << coreId << "] Barrier complete, advancing\n";
-           // syncMechanism->reset();
-                recordStageForInstruction(inst.id, "E");
-                memoryQueue.push_back(inst);
-                return;
-           }
+    if (memoryQueue.size() >= static_cast<size_t>(pipeline.getStageCapacity())) {
+        recordStageForInstruction(inst.id, "S");
+        cycleStallOccurred = true;
+        shouldStall = true;
+        stallCount++;
+        scoreboardRetire(inst);
+        return;
+    }
 
+    memoryQueue.push_back(inst);
+}
 
+bool PipelinedCore::execHalt(Instruction &inst, bool /*fromDecode*/, bool &/*shouldStall*/) {
+    SIM_LOG(EXEC, INFO, "[Core " << coreId << "] Executing HALT, flushing pipeline\n");
+    fetchQueue.clear();
+    flushQueue(decodeQueue);
+    flushQueue(executeQueue);
+    flushQueue(memoryQueue);
+    scoreboardRetire(inst);
+    halted=true;
+    recordStageForInstruction(inst.id, "M");
+    return false;
+}
 
-    if (inst.isArithmetic) {
-        int op1 = 0, op2 = 0;
+bool PipelinedCore::execSync(Instruction &inst, bool /*fromDecode*/, bool &shouldStall) {
+    // Phase 1: mark arrival, stall until all cores have arrived
+    SIM_LOG(SYNC, DEBUG, "[Core " << coreId << "] Arrived at SYNC\n");
+    enterShared();
+    syncMechanism->arrive(coreId);
 
-        if (fromDecode) {
-            op1 = getForwardedValue(inst.rs1);
-            op2 = (inst.opcode == "addi") ? inst.immediate : getForwardedValue(inst.rs2);
-        } else {
-            // ✨ FIX: use register values, not IDs
-            op1 = registers[inst.rs1];
-            op2 = (inst.opcode == "addi") ? inst.immediate : registers[inst.rs2];
-        }
+    if (!syncMechanism->canProceed(coreId)) {
+        // still waiting for the last core → spin here
+        recordStageForInstruction(inst.id, "S");
+        shouldStall = true;
+        cycleStallOccurred = true;
+        executeQueue.push_front(inst);
+        return false;
+    }
 
-        inst.resultValue = executeArithmetic(op1, op2, inst.immediate, inst.opcode);
-        inst.hasResult = true;
-        if (pipeline.isForwardingEnabled() && inst.rd > 0) {
-            setRegister(inst.rd, inst.resultValue);
-            registerAvailableCycle[inst.rd] = cycleCount;
-        }
+    // Phase 1 complete: push the SYNC into MEM so it can retire
+    SIM_LOG(SYNC, INFO, "[Core " << coreId << "] Barrier complete, advancing\n");
+    recordStageForInstruction(inst.id, "E");
+    memoryQueue.push_back(inst);
+    return false;
+}
 
-        std::cout << "[Core " << coreId << "] Arithmetic result: "
-                  << inst.resultValue << "\n";
-        std::cout << "    Clock cycle : " << cycleCount << std::endl;
-
-        if (inst.executeLatency > 1) {
-            inst.cyclesInExecute++;
-            if (inst.cyclesInExecute < inst.executeLatency) {
-                std::cout << "[Core " << coreId << "] Multi-cycle arithmetic: cycle "
-                          << inst.cyclesInExecute << " of " << inst.executeLatency << "\n";
-                executeQueue.push_back(inst);
-                stallCount++;
-                shouldStall = true;
-                return;
-            }
-        }
+bool PipelinedCore::execArithmetic(Instruction &inst, bool fromDecode, bool &shouldStall) {
+    int op1 = 0, op2 = 0;
+
+    if (fromDecode) {
+        op1 = getForwardedValue(inst.rs1);
+        op2 = (inst.op == Opcode::ADDI) ? inst.immediate : getForwardedValue(inst.rs2);
+    } else {
+        // ✨ FIX: use register values, not IDs
+        op1 = registers[inst.rs1];
+        op2 = (inst.op == Opcode::ADDI) ? inst.immediate : registers[inst.rs2];
     }
 
-    else if (inst.isMemory && (inst.opcode == "lw" || inst.opcode == "lw_spm")) {
-        int base = getForwardedValue(inst.rs1);
-        int effectiveAddress = base + inst.immediate;
+    inst.resultValue = executeArithmetic(op1, op2, inst.immediate, inst.op);
+    inst.hasResult = true;
+    scoreboardResult(inst);
+    if (pipeline.isForwardingEnabled() && inst.rd > 0) {
+        setRegister(inst.rd, inst.resultValue);
+        scoreboard.readyCycle[inst.rd] = cycleCount;
+    }
 
-        inst.resultValue = effectiveAddress;
+    SIM_LOG(EXEC, DEBUG, "[Core " << coreId << "] Arithmetic result: "
+              << inst.resultValue << "\n");
+    SIM_LOG(EXEC, DEBUG, "    Clock cycle : " << cycleCount << "\n");
 
-        std::cout << "[Core " << coreId << "] Memory load address calculated: "
-                << effectiveAddress << "\n";
-        std::cout << "    Clock cycle : " << cycleCount << std::endl;
-    }
-    else if (inst.isMemory && (inst.opcode == "sw" || inst.opcode == "sw_spm")) {
-        if (inst.opcode == "sw") {
-            std::cout << "[Core " << coreId << "] Executing SW: x" << inst.rs2
-                      << " (val=" << registers[inst.rs2] << ") to mem["
-                      << registers[inst.rs1] + inst.immediate << "]\n";
+    if (inst.executeLatency > 1) {
+        inst.cyclesInExecute++;
+        if (inst.cyclesInExecute < inst.executeLatency) {
+            SIM_LOG(EXEC, DEBUG, "[Core " << coreId << "] Multi-cycle arithmetic: cycle "
+                      << inst.cyclesInExecute << " of " << inst.executeLatency << "\n");
+            executeQueue.push_back(inst);
+            stallCount++;
+            shouldStall = true;
+            return false;
         }
+    }
+    return true;
+}
 
-        int base = getForwardedValue(inst.rs1);
-        int valueToStore = getForwardedValue(inst.rs2);
+bool PipelinedCore::execLoad(Instruction &inst, bool /*fromDecode*/, bool &/*shouldStall*/) {
+    int base = getForwardedValue(inst.rs1);
+    int effectiveAddress = base + inst.immediate;
 
-        int effectiveAddress = base + inst.immediate;
+    inst.resultValue = effectiveAddress;
 
-        inst.rs1 = effectiveAddress;
-        inst.rs2 = valueToStore;
+    SIM_LOG(EXEC, DEBUG, "[Core " << coreId << "] Memory load address calculated: "
+            << effectiveAddress << "\n");
+    SIM_LOG(EXEC, DEBUG, "    Clock cycle : " << cycleCount << "\n");
+    return true;
+}
 
-        std::cout << "[Core " << coreId << "] Memory store address calculated: "
-                << effectiveAddress << ", Value to store: " << valueToStore << "\n";
-        std::cout << "    Clock cycle : " << cycleCount << std::endl;
+bool PipelinedCore::execStore(Instruction &inst, bool /*fromDecode*/, bool &/*shouldStall*/) {
+    if (inst.op == Opcode::SW) {
+        SIM_LOG(EXEC, DEBUG, "[Core " << coreId << "] Executing SW: x" << inst.rs2
+                  << " (val=" << registers[inst.rs2] << ") to mem["
+                  << registers[inst.rs1] + inst.immediate << "]\n");
     }
-    // 1) Always execute the branch instruction itself:
-    else if (inst.isBranch) {
-        bool takeBranch = false;
-
-        // 1) SPECIAL: compute‐unit dispatch
-        if (inst.opcode == "beq" && inst.rs1 == 31) {
-            // “beq x31, <targetCID>, label”
-            if (coreId == inst.rs2) {
-                takeBranch = true;           // only THIS compute-unit takes it
-            } else {
-                inst.shouldExecute = false;  // all the others skip it entirely
-            }
-        }
-        // 2) Ordinary branches: beq/blt/bne/bge
-        else {
-            int op1 = getForwardedValue(inst.rs1);
-            int op2 = getForwardedValue(inst.rs2);
-            if      (inst.opcode == "beq") takeBranch = (op1 == op2);
-            else if (inst.opcode == "bne") takeBranch = (op1 != op2);
-            else if (inst.opcode == "blt") takeBranch = (op1 <  op2);
-            else if (inst.opcode == "bge") takeBranch = (op1 >= op2);
-        }
 
-        // debugging
-        std::cout << "[Core " << coreId
-                  << "] Branch " << (takeBranch ? "taken" : "not taken") << "\n";
-        std::cout << "    Clock cycle : " << cycleCount << std::endl;
-
-        if (takeBranch) {
-            // resolve label → targetPC
-            if (inst.targetPC < 0 && !inst.label.empty()) {
-                auto it = labels.find(inst.label);
-                if (it != labels.end()) inst.targetPC = it->second;
-            }
-            // redirect fetch, flush IF/ID
-            pc = inst.targetPC;
-            fetchQueue.clear();
-            decodeQueue.clear();
-            executeQueue.clear();
-                  memoryQueue.clear();
-        }
+    int base = getForwardedValue(inst.rs1);
+    int valueToStore = getForwardedValue(inst.rs2);
 
-        // only push into memory if shouldExecute still true
-        if (inst.shouldExecute)
-            memoryQueue.push_back(inst);
+    int effectiveAddress = base + inst.immediate;
 
-        return;
-    }
+    inst.rs1 = effectiveAddress;
+    inst.rs2 = valueToStore;
 
+    SIM_LOG(EXEC, DEBUG, "[Core " << coreId << "] Memory store address calculated: "
+            << effectiveAddress << ", Value to store: " << valueToStore << "\n");
+    SIM_LOG(EXEC, DEBUG, "    Clock cycle : " << cycleCount << "\n");
+    return true;
+}
 
+bool PipelinedCore::execBranch(Instruction &inst, bool /*fromDecode*/, bool &/*shouldStall*/) {
+    bool takeBranch = false;
 
-    else if (inst.isJump) {
-        if (inst.targetPC == -1 && !inst.label.empty()) {
-            auto it = labels.find(inst.label);
-            if (it != labels.end()) {
-                inst.targetPC = it->second;
-            }
-            else {
-                std::cerr << "[Core " << coreId << "] Error: label " << inst.label << " not found!\n";
-            }
-        }
-        int returnAddr = executeJump(inst);
-        if (returnAddr != -1) {
-            inst.resultValue = returnAddr;
-            inst.hasResult = true;
+    // 1) SPECIAL: compute‐unit dispatch
+    if (inst.op == Opcode::BEQ && inst.rs1 == 31) {
+        // “beq x31, <targetCID>, label”
+        if (coreId == inst.rs2) {
+            takeBranch = true;           // only THIS compute-unit takes it
         } else {
-            inst.hasResult = false; // no result to write
+            inst.shouldExecute = false;  // all the others skip it entirely
         }
-        std::cout << "[Core " << coreId << "] Jump to PC: "
-                << inst.targetPC << "\n";
-        std::cout << "    Clock cycle : " << cycleCount << std::endl;
+    }
+    // 2) Ordinary branches: beq/blt/bne/bge
+    else {
+        int op1 = getForwardedValue(inst.rs1);
+        int op2 = getForwardedValue(inst.rs2);
+        takeBranch = executeBranch(inst.op, op1, op2);
+    }
+
+    // debugging
+    SIM_LOG(EXEC, DEBUG, "[Core " << coreId
+              << "] Branch " << (takeBranch ? "taken" : "not taken") << "\n");
+    SIM_LOG(EXEC, DEBUG, "    Clock cycle : " << cycleCount << "\n");
+
+    if (takeBranch) {
+        // targetPC was resolved from the label at program load
+        // redirect fetch, flush IF/ID
         pc = inst.targetPC;
         fetchQueue.clear();
-        decodeQueue.clear();
-        executeQueue.clear();
-        memoryQueue.clear();
-        memoryQueue.push_back(inst);
-               recordStageForInstruction(inst.id, "E"); // or "M" depending where you record
-                return;
-    }
-    else if (inst.opcode == "la") {
-        if (!inst.label.empty()) {
-            auto it = labels.find(inst.label);
-            if (it != labels.end()) {
-                inst.resultValue = it->second;
-            }
-            else {
-                std::cerr << "[Core " << coreId << "] Error: label " << inst.label << " not found!\n";
-                inst.resultValue = 0;
-            }
-        }
-        else {
-            inst.resultValue = 0;
-        }
-        inst.hasResult = true;
-        std::cout << "[Core " << coreId << "] Loaded address: " << inst.resultValue
-                << " into register x" << inst.rd << "\n";
-        std::cout << "    Clock cycle : " << cycleCount << std::endl;
-    }
-    else if (inst.opcode == "invld1") {
-        std::cout << "[Core " << coreId << "] Executing invld1: invalidating L1D cache for core " << coreId << "\n";
-        memoryHierarchy->invalidateL1D(coreId);  // This must call the flush/invalidate method for your L1D cache
-        recordStageForInstruction(inst.id, "E");
-        memoryQueue.push_back(inst);  // Proceed to memory stage
-        return;
+        flushQueue(decodeQueue);
+        flushQueue(executeQueue);
+        flushQueue(memoryQueue);
     }
 
+    // only push into memory if shouldExecute still true
+    if (inst.shouldExecute)
+        memoryQueue.push_back(inst);
+    else
+        scoreboardRetire(inst);
 
-    if (memoryQueue.size() >= 2) {
-        recordStageForInstruction(inst.id, "S");
-        cycleStallOccurred = true;
-        shouldStall = true;
-        stallCount++;
-        return;
-    }
+    return false;
+}
 
+bool PipelinedCore::execJump(Instruction &inst, bool /*fromDecode*/, bool &/*shouldStall*/) {
+    int returnAddr = executeJump(inst);
+    if (returnAddr != -1) {
+        inst.resultValue = returnAddr;
+        inst.hasResult = true;
+    } else {
+        inst.hasResult = false; // no result to write
+    }
+    scoreboardResult(inst);
+    SIM_LOG(EXEC, DEBUG, "[Core " << coreId << "] Jump to PC: "
+            << inst.targetPC << "\n");
+    SIM_LOG(EXEC, DEBUG, "    Clock cycle : " << cycleCount << "\n");
+    pc = inst.targetPC;
+    fetchQueue.clear();
+    flushQueue(decodeQueue);
+    flushQueue(executeQueue);
+    flushQueue(memoryQueue);
     memoryQueue.push_back(inst);
+    recordStageForInstruction(inst.id, "E"); // or "M" depending where you record
+    return false;
+}
+
+bool PipelinedCore::execLoadAddress(Instruction &inst, bool /*fromDecode*/, bool &/*shouldStall*/) {
+    // The label's data address was stored in the immediate at program load
+    inst.resultValue = inst.immediate;
+    inst.hasResult = true;
+    scoreboardResult(inst);
+    SIM_LOG(EXEC, DEBUG, "[Core " << coreId << "] Loaded address: " << inst.resultValue
+            << " into register x" << inst.rd << "\n");
+    SIM_LOG(EXEC, DEBUG, "    Clock cycle : " << cycleCount << "\n");
+    return true;
+}
+
+bool PipelinedCore::execInvalidate(Instruction &inst, bool /*fromDecode*/, bool &/*shouldStall*/) {
+    SIM_LOG(CACHE, INFO, "[Core " << coreId << "] Executing invld1: invalidating L1D cache for core " << coreId << "\n");
+    enterShared();
+    memoryHierarchy->invalidateL1D(coreId);  // This must call the flush/invalidate method for your L1D cache
+    recordStageForInstruction(inst.id, "E");
+    memoryQueue.push_back(inst);  // Proceed to memory stage
+    return false;
+}
+
+bool PipelinedCore::execDefault(Instruction &/*inst*/, bool /*fromDecode*/, bool &/*shouldStall*/) {
+    return true;
 }
 
 void PipelinedCore::memoryAccess(bool &shouldStall) {
@@ -636,19 +624,19 @@ void PipelinedCore::memoryAccess(bool &shouldStall) {
             stallCount++;
             memoryQueue.front().memoryLatency = inst.memoryLatency;
             
-            std::cout << "[Core " << coreId << "] Memory stage: Waiting for memory access, "
-                      << inst.memoryLatency << " cycles remaining" << std::endl;
+            SIM_LOG(MEM, DEBUG, "[Core " << coreId << "] Memory stage: Waiting for memory access, "
+                      << inst.memoryLatency << " cycles remaining\n");
                       
             pipeline.incrementMemoryStallCycles(1);
             return;
         } else {
             // Memory access complete, continue processing
             memoryQueue.pop_front();
-            std::cout << "[Core " << coreId << "] Memory stage: Loaded value: "
+            SIM_LOG(MEM, DEBUG, "[Core " << coreId << "] Memory stage: Loaded value: "
                       << inst.resultValue
                       << " from address " /* the same effectiveAddress */
-                      << " (completion)" << std::endl;
-            std::cout << "    Clock cycle : " << cycleCount << std::endl;
+                      << " (completion)\n");
+            SIM_LOG(MEM, DEBUG, "    Clock cycle : " << cycleCount << "\n");
 
             // move to writeback, exactly as you do later
             writebackQueue.push_back(inst);
@@ -665,27 +653,21 @@ void PipelinedCore::memoryAccess(bool &shouldStall) {
         int segmentStart = coreId * segmentSizeBytes;
         int segmentEnd = (coreId + 1) * segmentSizeBytes - 4;
 
-        if (inst.opcode == "lw") {
+        if (inst.op == Opcode::LW) {
             if (memoryHierarchy) {
                 int effectiveAddress = inst.resultValue;
-                auto statsBefore = memoryHierarchy->getL1DCacheStats(coreId);
-                std::cout << "[Debug Core " << coreId << "] L1D stats before load - "
-                          << "Accesses=" << statsBefore.accesses
-                          << ", Hits=" << statsBefore.hits
-                          << ", Misses=" << statsBefore.misses << std::endl;
+                // A hit stays in this core's L1D unless another core may flush it this
+                // cycle. Tag-only loads read main memory even on a hit, so they always
+                // take the turn.
+                if (sharedTurn && !(sharedTurn->l1dHitsArePrivate() && !memoryHierarchy->isTagOnly() &&
+                                    memoryHierarchy->getL1D(coreId)->contains(effectiveAddress & ~0x3))) {
+                    sharedTurn->enter(coreId);
+                }
                 // Access memory through cache hierarchy
                 auto [latency, value] = memoryHierarchy->loadWord(coreId, effectiveAddress);
                 inst.resultValue = value;
                 inst.hasResult = true;
-                auto statsAfter = memoryHierarchy->getL1DCacheStats(coreId);
-                std::cout << "[Debug Core " << coreId << "] L1D stats after load - "
-                          << "Accesses=" << statsAfter.accesses
-                          << ", Hits=" << statsAfter.hits
-                          << ", Misses=" << statsAfter.misses << std::endl;
-
-                // Calculate the differences
-                std::cout << "[Debug Core " << coreId << "] L1D accesses for this load: "
-                          << (statsAfter.accesses - statsBefore.accesses) << std::endl;
+                scoreboardResult(inst);
 
                 if (latency > 1) {
                     // If memory access takes more than one cycle, stall the pipeline
@@ -700,9 +682,9 @@ void PipelinedCore::memoryAccess(bool &shouldStall) {
                     return;
                 }
 
-                std::cout << "[Core " << coreId << "] Memory stage: Loaded value: "
+                SIM_LOG(MEM, DEBUG, "[Core " << coreId << "] Memory stage: Loaded value: "
                         << inst.resultValue << " from address " << effectiveAddress
-                        << " (latency: " << latency << " cycles)" << std::endl;
+                        << " (latency: " << latency << " cycles)\n");
             } else {
                 // Legacy direct memory access
                 int effectiveAddress = inst.resultValue;
@@ -710,17 +692,19 @@ void PipelinedCore::memoryAccess(bool &shouldStall) {
                 inst.resultValue = value;
               //  inst.resultValue = sharedMemory->loadWord(coreId, effectiveAddress);
                 inst.hasResult = true;
-                std::cout << "[Core " << coreId << "] Memory stage: Loaded value: "
-                        << inst.resultValue << " from address " << effectiveAddress << "\n";
+                scoreboardResult(inst);
+                SIM_LOG(MEM, DEBUG, "[Core " << coreId << "] Memory stage: Loaded value: "
+                        << inst.resultValue << " from address " << effectiveAddress << "\n");
             }
-            std::cout << "    Clock cycle : " << cycleCount << std::endl;
+            SIM_LOG(MEM, DEBUG, "    Clock cycle : " << cycleCount << "\n");
         }
-        else if (inst.opcode == "sw") {
+        else if (inst.op == Opcode::SW) {
             if (memoryHierarchy) {
                 int effectiveAddress = inst.rs1;
                 int valueToStore = inst.rs2;
                 
-                // Access memory through cache hierarchy
+                // Stores write through to L2
+                enterShared();
                 int latency = memoryHierarchy->storeWord(coreId, effectiveAddress, valueToStore);
                 
                 if (latency > 1) {
@@ -736,9 +720,9 @@ void PipelinedCore::memoryAccess(bool &shouldStall) {
                     return;
                 }
                 
-                std::cout << "[Core " << coreId << "] Memory stage: Stored value: "
+                SIM_LOG(MEM, DEBUG, "[Core " << coreId << "] Memory stage: Stored value: "
                         << valueToStore << " to address " << effectiveAddress 
-                        << " (latency: " << latency << " cycles)" << std::endl;
+                        << " (latency: " << latency << " cycles)\n");
             } else {
                 // Legacy direct memory access
                 int effectiveAddress = inst.rs1;
@@ -746,16 +730,16 @@ void PipelinedCore::memoryAccess(bool &shouldStall) {
                 if (effectiveAddress >= segmentStart && effectiveAddress <= segmentEnd) {
                     memoryHierarchy->storeWord(coreId, effectiveAddress, valueToStore);
                     //sharedMemory->storeWord(coreId, effectiveAddress, valueToStore);
-                    std::cout << "[Core " << coreId << "] Memory stage: Stored value: "
-                            << valueToStore << " to address " << effectiveAddress << "\n";
+                    SIM_LOG(MEM, DEBUG, "[Core " << coreId << "] Memory stage: Stored value: "
+                            << valueToStore << " to address " << effectiveAddress << "\n");
                 } else {
-                    std::cout << "[Core " << coreId << "] Memory stage: Store address out of range: "
-                            << effectiveAddress << "\n";
+                    SIM_LOG(MEM, INFO, "[Core " << coreId << "] Memory stage: Store address out of range: "
+                            << effectiveAddress << "\n");
                 }
             }
-            std::cout << "    Clock cycle : " << cycleCount << std::endl;
+            SIM_LOG(MEM, DEBUG, "    Clock cycle : " << cycleCount << "\n");
         }
-        else if (inst.opcode == "lw_spm") {
+        else if (inst.op == Opcode::LW_SPM) {
             if (memoryHierarchy) {
                 int effectiveAddress = inst.resultValue;
                 
@@ -763,6 +747,7 @@ void PipelinedCore::memoryAccess(bool &shouldStall) {
                 auto [latency, value] = memoryHierarchy->loadWordFromSPM(coreId, effectiveAddress);
                 inst.resultValue = value;
                 inst.hasResult = true;
+                scoreboardResult(inst);
                 
                 if (latency > 1) {
                     // If SPM access takes more than one cycle, stall the pipeline
@@ -776,17 +761,18 @@ void PipelinedCore::memoryAccess(bool &shouldStall) {
                     return;
                 }
                 
-                std::cout << "[Core " << coreId << "] Memory stage: Loaded value: "
+                SIM_LOG(MEM, DEBUG, "[Core " << coreId << "] Memory stage: Loaded value: "
                         << inst.resultValue << " from SPM address " << effectiveAddress 
-                        << " (latency: " << latency << " cycles)" << std::endl;
+                        << " (latency: " << latency << " cycles)\n");
             } else {
                 // No SPM available, error
                 std::cerr << "[Core " << coreId << "] Error: SPM not available" << std::endl;
                 inst.resultValue = 0;
                 inst.hasResult = true;
+                scoreboardResult(inst);
             }
         }
-        else if (inst.opcode == "sw_spm") {
+        else if (inst.op == Opcode::SW_SPM) {
             if (memoryHierarchy) {
                 int effectiveAddress = inst.rs1;
                 int valueToStore = inst.rs2;
@@ -806,9 +792,9 @@ void PipelinedCore::memoryAccess(bool &shouldStall) {
                     return;
                 }
                 
-                std::cout << "[Core " << coreId << "] Memory stage: Stored value: "
+                SIM_LOG(MEM, DEBUG, "[Core " << coreId << "] Memory stage: Stored value: "
                         << valueToStore << " to SPM address " << effectiveAddress 
-                        << " (latency: " << latency << " cycles)" << std::endl;
+                        << " (latency: " << latency << " cycles)\n");
             } else {
                 // No SPM available, error
                 std::cerr << "[Core " << coreId << "] Error: SPM not available" << std::endl;
@@ -816,7 +802,7 @@ void PipelinedCore::memoryAccess(bool &shouldStall) {
         }
     }
 
-    if (writebackQueue.size() >= 2) {
+    if (writebackQueue.size() >= static_cast<size_t>(pipeline.getStageCapacity())) {
         recordStageForInstruction(inst.id, "S");
         cycleStallOccurred = true;
         shouldStall = true;
@@ -852,17 +838,19 @@ void PipelinedCore::writeback(bool &shouldStall) {
 
     Instruction inst = writebackQueue.front();
     writebackQueue.pop_front();
-    if (inst.opcode == "halt") {
-        std::cout << "[Core " << coreId
-                << "] Retiring HALT: flushing entire pipeline and stopping fetch\n";
+    scoreboardRetire(inst);
+    if (inst.op == Opcode::HALT) {
+        SIM_LOG(EXEC, INFO, "[Core " << coreId
+                << "] Retiring HALT: flushing entire pipeline and stopping fetch\n");
         // 1) flush everything
         fetchQueue.clear();
-        decodeQueue.clear();
-        executeQueue.clear();
-        memoryQueue.clear();
-        writebackQueue.clear();
+        flushQueue(decodeQueue);
+        flushQueue(executeQueue);
+        flushQueue(memoryQueue);
+        flushQueue(writebackQueue);
         // 2) record the retirement of HALT
         recordStageForInstruction(inst.id, "W");
+        enterShared();
         for (int c = 0; c < 4; ++c){
 
             memoryHierarchy->flushL1D(c);
@@ -882,11 +870,12 @@ void PipelinedCore::writeback(bool &shouldStall) {
         if (inst.rd != 0 && inst.rd != 31) {
             if (pipeline.isForwardingEnabled()) {
                 setRegister(inst.rd, inst.resultValue);
-                registerAvailableCycle[inst.rd] = cycleCount + 1;
+                scoreboard.readyCycle[inst.rd] = cycleCount + 1;
             }
 
             else {
-                pendingWrites[inst.rd] = inst.resultValue;
+                scoreboard.pendingWriteValid[inst.rd] = true;
+                scoreboard.pendingWriteValue[inst.rd] = inst.resultValue;
             }
         }
     }
@@ -895,18 +884,24 @@ void PipelinedCore::writeback(bool &shouldStall) {
     recordStageForInstruction(inst.id, "W");
 
     if (inst.isSync) {
+        enterShared();
         syncMechanism->retire(coreId);
-        std::cout << "[Core " << coreId << "] Retire SYNC in WB\n";
+        SIM_LOG(SYNC, DEBUG, "[Core " << coreId << "] Retire SYNC in WB\n");
     }
 }
 
+bool PipelinedCore::retiresSharedThisCycle() const {
+    return !writebackQueue.empty() &&
+           (writebackQueue.front().op == Opcode::HALT || writebackQueue.front().isSync);
+}
+
 bool PipelinedCore::isPipelineEmpty() const {
     return fetchQueue.empty() && decodeQueue.empty() &&
            executeQueue.empty() && memoryQueue.empty() && writebackQueue.empty();
 }
 
 bool PipelinedCore::checkHaltCondition() {
-    return (!writebackQueue.empty() && writebackQueue.front().opcode == "halt");
+    return (!writebackQueue.empty() && writebackQueue.front().op == Opcode::HALT);
 }
 
 bool PipelinedCore::isHalted() const {
@@ -917,20 +912,15 @@ void PipelinedCore::clockCycle() {
     if (halted) return;
     cycleStallOccurred = false;
 
-    for (auto &entry: pipelineRecord) {
-        if (!entry.second.empty()) {
-            if (entry.second.back() != "W") {
-                if (entry.second.size() < static_cast<size_t>(cycleCount + 1)) {
-                    entry.second.push_back("S");
-                }
-            }
-        }
-    }
+    // Unfinished rows are padded lazily, the next time they are touched
+    stallPadCycle = cycleCount;
 
     bool stallDecode = false, stallExecute = false, stallMemory = false, stallWriteback = false;
     writeback(stallWriteback);
     memoryAccess(stallMemory);
     execute(stallExecute);
+    // Decode and the rest of the cycle touch only this core
+    if (sharedTurn) sharedTurn->leave(coreId);
     decode(stallDecode);
 
     cycleCount++;
@@ -940,82 +930,118 @@ void PipelinedCore::clockCycle() {
     }
 
     if (!pipeline.isForwardingEnabled()) {
-        std::cout << "[Debug] End of cycle " << cycleCount << ": updating pending writes" << std::endl;
-        for (auto &entry: pendingWrites) {
-            std::cout << "[Debug] Updating reg x" << entry.first << " to " << entry.second << std::endl;
-            setRegister(entry.first, entry.second);
-            registerAvailableCycle[entry.first] = cycleCount;
+        SIM_LOG(EXEC, DEBUG, "[Debug] End of cycle " << cycleCount << ": updating pending writes\n");
+        for (int reg = 0; reg < NUM_REGISTERS; reg++) {
+            if (!scoreboard.pendingWriteValid[reg]) continue;
+            SIM_LOG(EXEC, DEBUG, "[Debug] Updating reg x" << reg << " to " << scoreboard.pendingWriteValue[reg] << "\n");
+            setRegister(reg, scoreboard.pendingWriteValue[reg]);
+            scoreboard.readyCycle[reg] = cycleCount;
+            scoreboard.pendingWriteValid[reg] = false;
         }
-        pendingWrites.clear();
     }
 }
 
-bool PipelinedCore::hasDataHazard(const Instruction &inst) const {
-    if (inst.rs1 < 0 && inst.rs2 < 0) {
-        return false;
+// Cycles MEM keeps counting down, or 0. The access completes in the cycle
+// after its latency reaches 0.
+int PipelinedCore::memoryWaitCyclesAhead() const {
+    if (memoryQueue.empty()) {
+        return 0;
     }
+    const Instruction &inst = memoryQueue.front();
+    return inst.waitingForMemory && inst.memoryLatency > 0 ? inst.memoryLatency : 0;
+}
 
-    for (const auto &execInst: executeQueue) {
-        if (execInst.rd > 0 && (execInst.rd == inst.rs1 || execInst.rd == inst.rs2)) {
-            if (!pipeline.isForwardingEnabled() || execInst.opcode == "lw") {
-                return true;
-            }
-        }
+int PipelinedCore::skipIdleCycles() {
+    if (!idleSkipping || halted || !writebackQueue.empty()) {
+        return 0;
+    }
+    if (SIM_LOG_ENABLED(EXEC, DEBUG) || SIM_LOG_ENABLED(MEM, DEBUG) || SIM_LOG_ENABLED(SYNC, DEBUG)) {
+        return 0;
     }
 
-    return false;
-}
+    const int memoryWait = memoryWaitCyclesAhead();
+    if (memoryWait == 0 && !memoryQueue.empty()) {
+        return 0;
+    }
 
-bool PipelinedCore::hasControlHazard(const Instruction &inst) const {
-    return inst.isBranch || inst.isJump;
+    int cycles;
+    if (!executeQueue.empty()) {
+        // A SYNC spinning in EX holds decode and fetch; whether the barrier
+        // stays closed next cycle is up to the other cores. Any other
+        // instruction in EX (a multi-cycle mul) is work.
+        if (!executeQueue.front().isSync) {
+            return 0;
+        }
+        enterShared();
+        syncMechanism->arrive(coreId);
+        if (syncMechanism->canProceed(coreId)) {
+            return 0;
+        }
+        cycles = 1;
+    } else {
+        // Nothing for EX and decode, and fetch held off by the full MEM queue,
+        // until the access completes
+        if (memoryWait == 0 || !decodeQueue.empty() || !fetchQueue.empty() ||
+            memoryQueue.size() < static_cast<size_t>(pipeline.getStageCapacity())) {
+            return 0;
+        }
+        cycles = memoryWait;
+    }
+
+    if (memoryWait > 0) {
+        Instruction &inst = memoryQueue.front();
+        recordIdleCells(inst.id, "S", cycles);
+        inst.memoryLatency -= cycles;
+        stallCount += cycles;
+        pipeline.incrementMemoryStallCycles(cycles);
+    }
+    // execute() records the SYNC as "E", then execSync() as "S"
+    cycleStallOccurred = !executeQueue.empty();
+    if (cycleStallOccurred) {
+        recordIdleCells(executeQueue.front().id, "ES", cycles);
+    }
+    stallPadCycle = cycleCount + cycles - 1;
+    cycleCount += cycles;
+    return cycles;
 }
 
-bool PipelinedCore::canForwardData(const Instruction &consumer, int &rs1Value, int &rs2Value) const {
-    rs1Value = getRegister(consumer.rs1);
-    rs2Value = getRegister(consumer.rs2);
-    bool rs1Found = false;
-    bool rs2Found = false;
-
-    for (const auto &inst: executeQueue) {
-        if (inst.hasResult) {
-            if (!rs1Found && inst.rd == consumer.rs1) {
-                rs1Value = inst.resultValue;
-                rs1Found = true;
-            }
-            if (!rs2Found && inst.rd == consumer.rs2) {
-                rs2Value = inst.resultValue;
-                rs2Found = true;
+void PipelinedCore::recordIdleCells(int instId, const char *stages, int cycles) {
+    // The first cell lands at the row's next column or after this cycle's
+    // padding; the rest follow back to back, since the row gains at least one
+    // cell per cycle while the padding moves one column per cycle
+    OpenTraceRow &row = openTraceRows.at(instId);
+    const int perCycle = static_cast<int>(std::strlen(stages));
+    const int first = std::max(row.nextColumn, cycleCount + 1);
+    const int cells = cycles * perCycle;
+    // "S" cells need no event: the converter fills the gaps in a row with "S"
+    if (trace.isOpen() && std::strcmp(stages, "S") != 0) {
+        for (int i = 0; i < cells; i++) {
+            if (stages[i % perCycle] != 'S') {
+                trace.record(instId, first + i, stages[i % perCycle]);
             }
         }
     }
+    row = OpenTraceRow{first + cells, stages[perCycle - 1]};
+}
 
-    for (const auto &inst: memoryQueue) {
-        if (inst.hasResult) {
-            if (!rs1Found && inst.rd == consumer.rs1) {
-                rs1Value = inst.resultValue;
-                rs1Found = true;
-            }
-            if (!rs2Found && inst.rd == consumer.rs2) {
-                rs2Value = inst.resultValue;
-                rs2Found = true;
-            }
-        }
+bool PipelinedCore::hasDataHazard(const Instruction &inst) const {
+    if (inst.rs1 < 0 && inst.rs2 < 0) {
+        return false;
     }
 
-    for (const auto &inst: writebackQueue) {
-        if (inst.hasResult) {
-            if (!rs1Found && inst.rd == consumer.rs1) {
-                rs1Value = inst.resultValue;
-                rs1Found = true;
-            }
-            if (!rs2Found && inst.rd == consumer.rs2) {
-                rs2Value = inst.resultValue;
-                rs2Found = true;
+    for (const auto &execInst: executeQueue) {
+        if (execInst.rd > 0 && (execInst.rd == inst.rs1 || execInst.rd == inst.rs2)) {
+            if (!pipeline.isForwardingEnabled() || execInst.op == Opcode::LW) {
+                return true;
             }
         }
     }
 
-    return rs1Found && rs2Found;
+    return false;
+}
+
+bool PipelinedCore::hasControlHazard(const Instruction &inst) const {
+    return inst.isBranch || inst.isJump;
 }
 
 // int PipelinedCore::executeArithmetic(const Instruction &inst) {
@@ -1036,40 +1062,33 @@ bool PipelinedCore::canForwardData(const Instruction &consumer, int &rs1Value, i
 //     }
 //     return 0;
 // }
-int PipelinedCore::executeArithmetic(int op1, int op2, int imm, const std::string &opcode) {
-    if (opcode == "add") return op1 + op2;
-    if (opcode == "sub") return op1 - op2;
-    if (opcode == "slt") return (op1 < op2) ? 1 : 0;
-    if (opcode == "mul") return op1 * op2;
-    if (opcode == "addi") return op1 + imm;
-    return 0;
-}
-
-bool PipelinedCore::executeBranch(const Instruction &inst) {
-    if (inst.opcode == "bne") {
-
-        return inst.rs1!= inst.rs2;
+int PipelinedCore::executeArithmetic(int op1, int op2, int imm, Opcode op) {
+    switch (op) {
+        case Opcode::ADD:  return op1 + op2;
+        case Opcode::SUB:  return op1 - op2;
+        case Opcode::SLT:  return (op1 < op2) ? 1 : 0;
+        case Opcode::MUL:  return op1 * op2;
+        case Opcode::ADDI: return op1 + imm;
+        default:           return 0;
     }
-    if (inst.opcode == "blt") {
+}
 
-        return inst.rs1 <inst.rs2 ;
+bool PipelinedCore::executeBranch(Opcode op, int op1, int op2) {
+    switch (op) {
+        case Opcode::BEQ: return op1 == op2;
+        case Opcode::BNE: return op1 != op2;
+        case Opcode::BLT: return op1 <  op2;
+        case Opcode::BGE: return op1 >= op2;
+        default:          return false;
     }
-    return false;
 }
 
 int PipelinedCore::executeJump(const Instruction &inst) {
     if (inst.rd == 0) {
         return -1; // Indicate no return address
     }
-    return pc + 1;
-}
-
-void PipelinedCore::setLabels(const std::unordered_map<std::string, int> &lbls) {
-    labels = lbls;
-}
-
-const std::unordered_map<std::string, int> &PipelinedCore::getLabels() const {
-    return labels;
+    // The instruction after the jal; pc is the fetch PC, which has moved on
+    return inst.pc + 1;
 }
 
 double PipelinedCore::getIPC() const {
@@ -1,18 +1,23 @@
 #ifndef PIPELINED_CORE_HPP
 #define PIPELINED_CORE_HPP
 
+#include <string>
 #include <vector>
-#include <deque>
+#include "ring_buffer.hpp"
+#include "register_scoreboard.hpp"
+#include "pipeline_trace.hpp"
 #include <unordered_map>
 #include <memory>
+#include <array>
 #include "pipeline.hpp"
 #include "shared_memory.hpp"
 #include "memory_hierarchy.hpp"
 #include "sync_mechanism.hpp"
+#include "spin_barrier.hpp"
 
 struct FetchEntry {
     int fetchId;
-    std::string rawInst;
+    int pc;     // index into the shared decoded program table
 };
 
 class PipelinedCore {
@@ -34,23 +39,42 @@ public:
     void pushToFetchQueue(const FetchEntry& entry) { fetchQueue.push_back(entry); }
     void recordStageForInstruction(int instId, const std::string& stage);
     void clockCycle();
+
+    // Idle-cycle skipping. When this cycle would only count down a memory
+    // access or spin on a closed barrier, with fetch held off, accounts for it
+    // as clockCycle() would (stall counts, trace cells, cycle count) together
+    // with the following cycles that stay idle whatever the other cores do,
+    // and returns how many cycles that was; the caller leaves the core alone
+    // for the rest of them. Returns 0 without changing anything when the core
+    // has work this cycle, or while per-cycle trace messages are enabled.
+    int skipIdleCycles();
+    // Off: skipIdleCycles() always returns 0, so every cycle is clocked
+    void setIdleSkipping(bool enabled) { idleSkipping = enabled; }
     
     int getFetchQueueSize() const { return fetchQueue.size(); }
+    // Binary trace file opened by the next reset() (default
+    // pipeline_core<id>.trace); empty records no trace
+    void setTraceFile(const std::string& path) { traceFile = path; }
+    // Ends the binary trace; call once the run is over
+    void finishTrace();
+    // Converts the finished trace to the dense per-cycle CSV
     void exportPipelineRecord(const std::string& filename) const;
     
     int getRegister(int index) const;
     void setRegister(int index, int value);
     
     const std::vector<int>& getRegisters() const { return registers; }
+
+    // Takes over architectural state produced elsewhere (the functional engine):
+    // registers, next PC and halt flag. The pipeline restarts empty from that PC;
+    // cycle counts and the trace carry on.
+    void loadArchitecturalState(int newPC, const std::vector<int>& values, bool isHalted);
     
     int getCycleCount() const { return cycleCount; }
     int getStallCount() const { return stallCount; }
     int getInstructionCount() const { return instructionCount; }
     double getIPC() const;
     
-    void setLabels(const std::unordered_map<std::string, int>& lbls);
-    const std::unordered_map<std::string, int>& getLabels() const;
-    
     void setInstructionLatency(const std::string& instruction, int latency) {
         pipeline.setInstructionLatency(instruction, latency);
     }
@@ -58,8 +82,15 @@ public:
     void setForwardingEnabled(bool enabled) {
         pipeline.setForwardingEnabled(enabled);
     }
+
+    // Occupancy limit for every stage queue; reallocates (and empties) the
+    // queues. Throws std::invalid_argument as Pipeline::setStageCapacity does.
+    void setStageCapacity(int capacity);
+    int getStageCapacity() const { return pipeline.getStageCapacity(); }
     int fetchWaitCyclesRemaining = 0;
     bool fetchInProgress = false;
+    // Cleared to let the pipeline drain (end of a detailed sampling window)
+    bool fetchEnabled = true;
 
     int fetchCounter = 0;
     void setMemoryHierarchy(std::shared_ptr<MemoryHierarchy> memHierarchy) {
@@ -69,6 +100,11 @@ public:
     void setSyncMechanism(std::shared_ptr<SyncMechanism> syncMech) {
         this->syncMechanism = syncMech;
     }
+
+    // Program decoded once at load time; shared read-only by every core
+    void setDecodedProgram(std::shared_ptr<const std::vector<Instruction>> program) {
+        this->decodedProgram = program;
+    }
     
     int getMemoryStallCycles() const { return pipeline.getMemoryStallCycles(); }
     std::shared_ptr<MemoryHierarchy> getMemoryHierarchy() const {
@@ -121,6 +157,12 @@ public:
         return syncMechanism;
     }
 
+    // Set by the parallel engine for the length of a run; nullptr when serial
+    void setSharedAccessTurn(SharedAccessTurn* turn) { sharedTurn = turn; }
+    // True when writeback retires a HALT or SYNC this cycle, which may flush
+    // the L1D caches of other cores
+    bool retiresSharedThisCycle() const;
+
 private:
 
    // bool terminated = false;
@@ -129,6 +171,13 @@ private:
     //std::shared_ptr<SharedMemory> sharedMemory;
     std::shared_ptr<MemoryHierarchy> memoryHierarchy;
     std::shared_ptr<SyncMechanism> syncMechanism;
+    SharedAccessTurn* sharedTurn = nullptr;
+    bool idleSkipping = true;
+
+    void enterShared() {
+        if (sharedTurn) sharedTurn->enter(coreId);
+    }
+    std::shared_ptr<const std::vector<Instruction>> decodedProgram;
     int pc;
     Pipeline pipeline;
     int fetchWaitCycles = 0;
@@ -136,17 +185,29 @@ private:
     bool hasPendingFetch = false;
 
     
-    std::deque<FetchEntry> fetchQueue;
-    std::deque<Instruction> decodeQueue;
-    std::deque<Instruction> executeQueue;
-    std::deque<Instruction> memoryQueue;
-    std::deque<Instruction> writebackQueue;
+    RingBuffer<FetchEntry> fetchQueue;
+    RingBuffer<Instruction> decodeQueue;
+    RingBuffer<Instruction> executeQueue;
+    RingBuffer<Instruction> memoryQueue;
+    RingBuffer<Instruction> writebackQueue;
     
-    std::unordered_map<int, int> pendingWrites;
-    std::unordered_map<int, int> registerAvailableCycle;
+    RegisterScoreboard scoreboard;
     
-    std::unordered_map<std::string, int> labels;
-    std::unordered_map<int, std::vector<std::string>> pipelineRecord;
+    // Stage cells are streamed to the trace as they are recorded. Only instructions
+    // that have not reached W yet are kept here, to place their next cell.
+    struct OpenTraceRow {
+        int nextColumn;
+        char lastStage;
+    };
+    std::unordered_map<int, OpenTraceRow> openTraceRows;
+    PipelineTraceWriter trace;
+    std::string traceFile;
+    // Last cycle at which every unfinished row is owed an "S" cell
+    int stallPadCycle = -1;
+    // Records the cells `cycles` idle cycles would give instId, one per letter
+    // of `stages` each cycle, starting this cycle
+    void recordIdleCells(int instId, const char *stages, int cycles);
+    int memoryWaitCyclesAhead() const;
     
     int cycleCount;
     int stallCount;
@@ -165,20 +226,41 @@ private:
     bool checkHaltCondition();
     bool hasDataHazard(const Instruction &inst) const;
     bool hasControlHazard(const Instruction &inst) const;
-    bool isRegisterInUse(int reg) const;
     bool operandsReadyForUse(const Instruction &inst) const;
     bool operandsAvailable(const Instruction &consumer) const;
     
     int getForwardedValue(int reg) const;
-    bool canForwardData(const Instruction &consumer, int &rs1Value, int &rs2Value) const;
 
-    int executeArithmetic(int op1, int op2, int imm, const std::string &opcode);
+    // Scoreboard bookkeeping: an instruction is issued when it enters the decode
+    // queue and retired when it leaves the pipeline (writeback, drop or flush)
+    void scoreboardIssue(const Instruction &inst);
+    void scoreboardResult(const Instruction &inst);
+    void scoreboardRetire(const Instruction &inst);
+    void flushQueue(RingBuffer<Instruction> &queue);
+
+    int executeArithmetic(int op1, int op2, int imm, Opcode op);
 
     //  int executeArithmetic(const Instruction &inst);
 
     //  int executeArithmetic(const Instruction &inst);
-    bool executeBranch(const Instruction &inst);
+    bool executeBranch(Opcode op, int op1, int op2);
     int executeJump(const Instruction &inst);
+
+    // Per-opcode execute handlers; each returns true if the instruction should
+    // continue into the memory queue through the common path in execute()
+    using ExecHandler = bool (PipelinedCore::*)(Instruction &inst, bool fromDecode, bool &shouldStall);
+    static const std::array<ExecHandler, NUM_OPCODES> execHandlers;
+
+    bool execHalt(Instruction &inst, bool fromDecode, bool &shouldStall);
+    bool execSync(Instruction &inst, bool fromDecode, bool &shouldStall);
+    bool execArithmetic(Instruction &inst, bool fromDecode, bool &shouldStall);
+    bool execLoad(Instruction &inst, bool fromDecode, bool &shouldStall);
+    bool execStore(Instruction &inst, bool fromDecode, bool &shouldStall);
+    bool execBranch(Instruction &inst, bool fromDecode, bool &shouldStall);
+    bool execJump(Instruction &inst, bool fromDecode, bool &shouldStall);
+    bool execLoadAddress(Instruction &inst, bool fromDecode, bool &shouldStall);
+    bool execInvalidate(Instruction &inst, bool fromDecode, bool &shouldStall);
+    bool execDefault(Instruction &inst, bool fromDecode, bool &shouldStall);
 };
 
 #endif // PIPELINED_CORE_HPP
\ No newline at end of file
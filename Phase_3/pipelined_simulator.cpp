@@ -6,9 +6,17 @@
 #include <stdexcept>
 #include <iomanip>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
 #include "centralized_fetch.hpp"
+#include "parallel_engine.hpp"
 #include "pipelined_core.hpp"
 #include "memory_hierarchy.hpp"
+#include "sim_log.hpp"
+#include "instruction_parser.hpp"
+#include "assembly_lexer.hpp"
+#include "checkpoint.hpp"
 
 PipelinedSimulator::PipelinedSimulator(int numCores, bool enableForwarding)
     :
@@ -35,6 +43,7 @@ PipelinedSimulator::PipelinedSimulator(int numCores, bool enableForwarding)
             cores.back().setMemoryHierarchy(memoryHierarchy);
         cores.back().setSyncMechanism(syncMechanism);
     }
+    functionalEngine.setMemoryHierarchy(memoryHierarchy);
 
 
 
@@ -78,8 +87,7 @@ void PipelinedSimulator::loadProgramFromFile(const std::string &filename) {
 }
 
 void PipelinedSimulator::loadProgram(const std::string& assembly) {
-    std::istringstream iss(assembly);
-    std::string line;
+    std::string_view source = assembly;
     program.clear();
     labelMap.clear();
 
@@ -89,119 +97,116 @@ void PipelinedSimulator::loadProgram(const std::string& assembly) {
     int programCounter = 0;
 
 
-    std::string accumulatedData;
-
-
-    auto flushData = [&]() {
-        if (!accumulatedData.empty()) {
-            std::istringstream dataStream(accumulatedData);
-            std::string token;
-            while (std::getline(dataStream, token, ',')) {
-                token.erase(0, token.find_first_not_of(" \t\n\r"));
-                token.erase(token.find_last_not_of(" \t\n\r") + 1);
-                if (!token.empty()) {
-                    int value = std::stoi(token);
-                    // Store data to the shared memory at a single location
-                    // All cores can access the same memory location
-                   // sharedMemory->setWord(dataPointer, value);
-                    memoryHierarchy->getMainMemory()->setWord(dataPointer, value);
-                    dataPointer += 4;
+    // Store each comma-separated value of a .word list to consecutive words
+    auto storeData = [&](std::string_view values) {
+        while (!values.empty()) {
+            size_t comma = values.find(',');
+            std::string_view token = AssemblyLexer::trim(values.substr(0, comma));
+            if (!token.empty()) {
+                int value = 0;
+                if (!AssemblyLexer::parseInt(token, value)) {
+                    throw std::runtime_error("Invalid data value: " + std::string(token));
                 }
+                // Store data to the shared memory at a single location
+                // All cores can access the same memory location
+               // sharedMemory->setWord(dataPointer, value);
+                memoryHierarchy->getMainMemory()->setWord(dataPointer, value);
+                dataPointer += 4;
             }
-            accumulatedData = "";
+            if (comma == std::string_view::npos) break;
+            values = values.substr(comma + 1);
         }
     };
 
-    while (std::getline(iss, line)) {
-
-        size_t commentPos = line.find('#');
-        if (commentPos != std::string::npos) {
-            line = line.substr(0, commentPos);
-        }
-
-
-        line.erase(0, line.find_first_not_of(" \t\n\r"));
-        line.erase(line.find_last_not_of(" \t\n\r") + 1);
+    while (!source.empty()) {
+        std::string_view line = AssemblyLexer::nextLine(source);
+        line = AssemblyLexer::trim(AssemblyLexer::stripComment(line));
 
         if (line.empty())
             continue;
 
 
         if (line[0] == '.') {
-            if (line.find(".data") != std::string::npos) {
+            if (line.find(".data") != std::string_view::npos) {
                 inDataSection = true;
                 inTextSection = false;
-                flushData();
                 continue;
-            } else if (line.find(".text") != std::string::npos) {
-                flushData();
+            } else if (line.find(".text") != std::string_view::npos) {
                 inTextSection = true;
                 inDataSection = false;
                 continue;
-            } else if (line.find(".globl") != std::string::npos) {
+            } else if (line.find(".globl") != std::string_view::npos) {
                 continue;
             }
         }
 
         if (inDataSection) {
             size_t colonPos = line.find(':');
-            if (colonPos != std::string::npos) {
-
-                flushData();
-
-
-                std::string label = line.substr(0, colonPos);
-                label.erase(0, label.find_first_not_of(" \t\n\r"));
-                label.erase(label.find_last_not_of(" \t\n\r") + 1);
+            if (colonPos != std::string_view::npos) {
+                std::string_view label = AssemblyLexer::trim(line.substr(0, colonPos));
                 if (!label.empty() && label[0] == '.')
-                    label = label.substr(1);
+                    label.remove_prefix(1);
 
-                labelMap[label] = dataPointer;
+                labelMap[std::string(label)] = dataPointer;
 
 
-                std::string rest = line.substr(colonPos + 1);
-                rest.erase(0, rest.find_first_not_of(" \t\n\r"));
+                std::string_view rest = AssemblyLexer::trimLeft(line.substr(colonPos + 1));
                 size_t pos = rest.find(".word");
-                if (pos != std::string::npos)
+                if (pos != std::string_view::npos)
                     rest = rest.substr(pos + 5);
-                accumulatedData = rest;
+                storeData(rest);
             } else {
-
-                if (!accumulatedData.empty())
-                    accumulatedData = accumulatedData + "," + line;
-                else
-                    accumulatedData = line;
+                storeData(line);
             }
         } else if (inTextSection) {
             size_t colonPos = line.find(':');
-            if (colonPos != std::string::npos) {
-                std::string label = line.substr(0, colonPos);
-                label.erase(0, label.find_first_not_of(" \t\n\r"));
-                label.erase(label.find_last_not_of(" \t\n\r") + 1);
-                labelMap[label] = programCounter;
-
-                std::string rest = line.substr(colonPos + 1);
-                rest.erase(0, rest.find_first_not_of(" \t\n\r"));
+            if (colonPos != std::string_view::npos) {
+                std::string_view label = AssemblyLexer::trim(line.substr(0, colonPos));
+                labelMap[std::string(label)] = programCounter;
+
+                std::string_view rest = AssemblyLexer::trimLeft(line.substr(colonPos + 1));
                 if (!rest.empty()) {
-                    program.push_back(rest);
+                    program.emplace_back(rest);
                     programCounter++;
                 }
             } else {
-                program.push_back(line);
+                program.emplace_back(line);
                 programCounter++;
             }
         }
     }
 
 
-    if (inDataSection && !accumulatedData.empty()) {
-        flushData();
+    // Decode every instruction once; cores copy entries out of this table by PC.
+    // Labels are resolved here too: branch/jal get their absolute targetPC and
+    // la carries the data address in its immediate, so execute never looks one up.
+    auto decoded = std::make_shared<std::vector<Instruction>>();
+    decoded->reserve(program.size());
+    for (size_t i = 0; i < program.size(); i++) {
+        std::string_view label;
+        Instruction inst = InstructionParser::parseInstruction(program[i], -1, label);
+        inst.pc = static_cast<int>(i);
+
+        if (!label.empty()) {
+            auto it = labelMap.find(std::string(label));
+            if (it == labelMap.end()) {
+                throw std::runtime_error("Undefined label '" + std::string(label) +
+                                         "' in instruction: " + program[i]);
+            }
+            if (inst.op == Opcode::LA) {
+                inst.immediate = it->second;
+            } else {
+                inst.targetPC = it->second;
+            }
+        }
+        decoded->push_back(inst);
     }
-
+    decodedProgram = decoded;
+    functionalEngine.setProgram(decodedProgram);
 
     for (auto& core : cores) {
         core.reset();
-        core.setLabels(labelMap);
+        core.setDecodedProgram(decodedProgram);
         for (const auto& [instruction, latency] : instructionLatencies) {
             core.setInstructionLatency(instruction, latency);
         }
@@ -215,20 +220,29 @@ void PipelinedSimulator::loadProgram(const std::string& assembly) {
 
 void PipelinedSimulator::loadCacheConfig(const std::string& filename) {
     try {
-        memoryHierarchy = std::make_shared<MemoryHierarchy>(cores.size(), filename);
-
-        // Connect memory hierarchy to cores
-        for (auto& core : cores) {
-            core.setMemoryHierarchy(memoryHierarchy);
-        }
-
-        std::cout << "Cache configuration loaded from " << filename << std::endl;
+        useMemoryHierarchy(std::make_shared<MemoryHierarchy>(cores.size(), filename));
+        SIM_LOG(CACHE, INFO, "Cache configuration loaded from " << filename << "\n");
     } catch (const std::exception& e) {
         std::cerr << "Error loading cache configuration: " << e.what() << std::endl;
         std::cerr << "Continuing with previous or default configuration" << std::endl;
     }
 }
 
+void PipelinedSimulator::setCacheConfig(const CacheConfig& config) {
+    useMemoryHierarchy(std::make_shared<MemoryHierarchy>(cores.size(), config));
+}
+
+void PipelinedSimulator::useMemoryHierarchy(std::shared_ptr<MemoryHierarchy> hierarchy) {
+    memoryHierarchy = std::move(hierarchy);
+
+    // Connect memory hierarchy to cores
+    for (auto& core : cores) {
+        core.setMemoryHierarchy(memoryHierarchy);
+    }
+    syncMechanism->setMemoryHierarchy(memoryHierarchy.get());
+    functionalEngine.setMemoryHierarchy(memoryHierarchy);
+}
+
 void PipelinedSimulator::setForwardingEnabled(bool enabled) {
     forwardingEnabled = enabled;
     for (auto &core: cores) {
@@ -240,6 +254,26 @@ bool PipelinedSimulator::isForwardingEnabled() const {
     return forwardingEnabled;
 }
 
+void PipelinedSimulator::setIdleSkipping(bool enabled) {
+    idleSkipping = enabled;
+    for (auto &core: cores) {
+        core.setIdleSkipping(enabled);
+    }
+}
+
+void PipelinedSimulator::setStageCapacity(int capacity) {
+    Pipeline::checkStageCapacity(capacity);
+    stageCapacity = capacity;
+
+    for (auto &core: cores) {
+        core.setStageCapacity(capacity);
+    }
+}
+
+int PipelinedSimulator::getStageCapacity() const {
+    return stageCapacity;
+}
+
 void PipelinedSimulator::setInstructionLatency(const std::string &instruction, int latency) {
     if (latency < 1) {
         throw std::invalid_argument("Instruction latency must be at least 1");
@@ -260,36 +294,402 @@ int PipelinedSimulator::getInstructionLatency(const std::string &instruction) co
     return 1;
 }
 
+void PipelinedSimulator::setHostThreads(int threads) {
+    if (threads < 1) {
+        throw std::invalid_argument("Host threads must be at least 1");
+    }
+    hostThreads = threads;
+}
+
+void PipelinedSimulator::setQuantum(int cycles) {
+    if (cycles < 1) {
+        throw std::invalid_argument("Quantum must be at least 1 cycle");
+    }
+    quantum = cycles;
+}
+
+void PipelinedSimulator::setTracePrefix(const std::string &prefix) {
+    tracePrefix = prefix;
+    for (auto &core: cores) {
+        core.setTraceFile(prefix.empty() ? "" : prefix + std::to_string(core.getCoreId()) + ".trace");
+    }
+}
+
+FastForwardSummary PipelinedSimulator::fastForward(const FastForwardOptions &options) {
+    if (!decodedProgram) {
+        throw std::logic_error("No program loaded");
+    }
+    if (!memoryHierarchy) {
+        throw std::logic_error("Fast-forward needs the memory hierarchy");
+    }
+
+    int markerPC = -1;
+    if (!options.stopLabel.empty()) {
+        auto it = labelMap.find(options.stopLabel);
+        if (it == labelMap.end()) {
+            throw std::invalid_argument("Unknown label: " + options.stopLabel);
+        }
+        markerPC = it->second;
+    }
+
+    std::vector<FunctionalCoreState> states(cores.size());
+    for (size_t i = 0; i < cores.size(); i++) {
+        const PipelinedCore &core = cores[i];
+        if (!core.isPipelineEmpty()) {
+            throw std::logic_error("Fast-forward needs every pipeline to be empty");
+        }
+        FunctionalCoreState &state = states[i];
+        state.coreId = core.getCoreId();
+        state.pc = core.getPC();
+        std::copy(core.getRegisters().begin(), core.getRegisters().end(), state.registers.begin());
+        if (core.isHalted()) {
+            state.stop = FunctionalStop::HALTED;
+        } else if (state.pc >= static_cast<int>(decodedProgram->size())) {
+            state.stop = FunctionalStop::END_OF_PROGRAM;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    functionalEngine.run(states, options.maxInstructions, markerPC, options.warmCaches);
+
+    FastForwardSummary summary;
+    summary.warmCaches = options.warmCaches;
+    for (size_t i = 0; i < cores.size(); i++) {
+        const FunctionalCoreState &state = states[i];
+        std::vector<int> registers(state.registers.begin(),
+                                   state.registers.begin() + PipelinedCore::NUM_REGISTERS);
+        cores[i].loadArchitecturalState(state.pc, registers, state.stop == FunctionalStop::HALTED);
+        summary.instructions.push_back(state.instructions);
+        summary.stops.push_back(state.stop);
+        summary.pcs.push_back(state.pc);
+    }
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return summary;
+}
+
+void PipelinedSimulator::printFastForwardSummary(const FastForwardSummary &summary) const {
+    static const char *const stopNames[] = {
+        "running", "waiting at sync", "instruction limit", "stop label", "halted", "end of program"
+    };
+
+    uint64_t totalInstructions = 0;
+    std::cout << "\n=== Fast-forward ===\n";
+    for (size_t i = 0; i < summary.instructions.size(); i++) {
+        totalInstructions += summary.instructions[i];
+        std::cout << "Core " << i << ": " << summary.instructions[i]
+                  << " instructions, PC " << summary.pcs[i] << " ("
+                  << stopNames[static_cast<int>(summary.stops[i])] << ")\n";
+    }
+    std::cout << "Total: " << totalInstructions << " instructions in "
+              << std::fixed << std::setprecision(3) << summary.seconds * 1000.0 << " ms";
+    if (summary.seconds > 0) {
+        std::cout << " (" << std::setprecision(1) << totalInstructions / summary.seconds / 1e6 << " MIPS)";
+    }
+    std::cout << (summary.warmCaches ? ", caches warmed" : "") << "\n";
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
+
+uint64_t PipelinedSimulator::programHash() const {
+    uint64_t value = Checkpoint::hash("");
+    for (const auto &line: program) {
+        value = Checkpoint::hash(line + "\n", value);
+    }
+    return value;
+}
+
+// Cache sections are keyed by (type, index): 0 = L1I, 1 = L1D, 2 = L2
+Cache *PipelinedSimulator::checkpointCache(uint8_t type, int index) const {
+    if (type == 2) {
+        return index == 0 ? memoryHierarchy->getL2().get() : nullptr;
+    }
+    if (index < 0 || index >= static_cast<int>(cores.size()) || type > 2) {
+        return nullptr;
+    }
+    if (type == 0) {
+        return memoryHierarchy->getL1I(index).get();
+    }
+    return memoryHierarchy->getL1D(index).get();
+}
+
+void PipelinedSimulator::saveCheckpoint(const std::string &filename, bool includeCaches) const {
+    if (!decodedProgram) {
+        throw std::logic_error("No program loaded");
+    }
+    if (!memoryHierarchy) {
+        throw std::logic_error("Checkpoints need the memory hierarchy");
+    }
+    for (const auto &core: cores) {
+        if (!core.isPipelineEmpty()) {
+            throw std::logic_error("Checkpoints need every pipeline to be empty");
+        }
+    }
+
+    CheckpointWriter out;
+    out.writeRaw(Checkpoint::MAGIC, sizeof(Checkpoint::MAGIC));
+    out.write<uint32_t>(Checkpoint::VERSION);
+    out.write<uint32_t>(static_cast<uint32_t>(cores.size()));
+    out.write<uint64_t>(programHash());
+    out.write<uint32_t>((includeCaches ? Checkpoint::FLAG_CACHES : 0) |
+                        (memoryHierarchy->isTagOnly() ? Checkpoint::FLAG_TAG_ONLY : 0));
+
+    CheckpointWriter coreSection;
+    for (const auto &core: cores) {
+        coreSection.write<int32_t>(core.getPC());
+        coreSection.write<uint8_t>(core.isHalted());
+        for (int value: core.getRegisters()) {
+            coreSection.write<int32_t>(value);
+        }
+    }
+    out.writeSection("CORE", coreSection);
+
+    // Memory as the program sees it: L2 lines are newer than main memory and
+    // L1D lines newer than L2, so a restore is correct even with cold caches
+    std::vector<uint8_t> image = memoryHierarchy->getRawMemory();
+    memoryHierarchy->getL2()->overlayDirtyLines(image);
+    for (size_t i = 0; i < cores.size(); i++) {
+        memoryHierarchy->getL1D(static_cast<int>(i))->overlayDirtyLines(image);
+    }
+    CheckpointWriter memorySection;
+    memorySection.writeBytes(image);
+    out.writeSection("MEM ", memorySection);
+
+    CheckpointWriter spmSection;
+    for (size_t i = 0; i < cores.size(); i++) {
+        spmSection.writeBytes(memoryHierarchy->getSPM(static_cast<int>(i))->getRawMemory());
+    }
+    out.writeSection("SPM ", spmSection);
+
+    CheckpointWriter syncSection;
+    syncMechanism->saveState(syncSection);
+    out.writeSection("SYNC", syncSection);
+
+    if (includeCaches) {
+        for (uint8_t type = 0; type <= 2; type++) {
+            int count = type == 2 ? 1 : static_cast<int>(cores.size());
+            for (int index = 0; index < count; index++) {
+                CheckpointWriter cacheSection;
+                cacheSection.write<uint8_t>(type);
+                cacheSection.write<int32_t>(index);
+                checkpointCache(type, index)->saveState(cacheSection);
+                out.writeSection("CACH", cacheSection);
+            }
+        }
+    }
+    out.writeSection("END ", CheckpointWriter());
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Cannot open checkpoint file for writing: " + filename);
+    }
+    file.write(out.data().data(), static_cast<std::streamsize>(out.data().size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write checkpoint file: " + filename);
+    }
+    std::cout << "Checkpoint saved to " << filename << " (" << out.data().size() << " bytes"
+              << (includeCaches ? ", with caches" : "") << ")\n";
+}
+
+void PipelinedSimulator::restoreCheckpoint(const std::string &filename) {
+    if (!decodedProgram) {
+        throw std::logic_error("No program loaded");
+    }
+    if (!memoryHierarchy) {
+        throw std::logic_error("Checkpoints need the memory hierarchy");
+    }
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open checkpoint file: " + filename);
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    CheckpointReader in(contents.str());
+
+    char magic[4];
+    in.readRaw(magic, sizeof(magic));
+    if (std::memcmp(magic, Checkpoint::MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error(filename + " is not a simulator checkpoint");
+    }
+    uint32_t version = in.read<uint32_t>();
+    if (version != Checkpoint::VERSION) {
+        throw std::runtime_error("Unsupported checkpoint version " + std::to_string(version));
+    }
+    uint32_t numCores = in.read<uint32_t>();
+    if (numCores != cores.size()) {
+        throw std::runtime_error("Checkpoint has " + std::to_string(numCores) + " cores, simulator has " +
+                                 std::to_string(cores.size()));
+    }
+    if (in.read<uint64_t>() != programHash()) {
+        throw std::runtime_error("Checkpoint was taken with a different program");
+    }
+    // Otherwise the sections present are what counts
+    uint32_t flags = in.read<uint32_t>();
+    // Tag-only lines have no data, so a data-mode hierarchy cannot use them
+    bool cachesUsable = !(flags & Checkpoint::FLAG_TAG_ONLY) || memoryHierarchy->isTagOnly();
+
+    // Read everything before touching the simulator so a bad file changes nothing
+    std::vector<std::pair<std::string, CheckpointReader>> sections;
+    std::string tag;
+    while (tag != "END ") {
+        CheckpointReader section;
+        in.readSection(tag, section);
+        sections.emplace_back(tag, section);
+    }
+    auto find = [&](const char *name) -> CheckpointReader {
+        for (const auto &section: sections) {
+            if (section.first == name) {
+                return section.second;
+            }
+        }
+        throw std::runtime_error(std::string("Checkpoint has no ") + name + " section");
+    };
+
+    CheckpointReader coreSection = find("CORE");
+    std::vector<int> pcs(cores.size());
+    std::vector<bool> halted(cores.size());
+    std::vector<std::vector<int>> registers(cores.size(), std::vector<int>(PipelinedCore::NUM_REGISTERS));
+    for (size_t i = 0; i < cores.size(); i++) {
+        pcs[i] = coreSection.read<int32_t>();
+        halted[i] = coreSection.read<uint8_t>() != 0;
+        for (int &value: registers[i]) {
+            value = coreSection.read<int32_t>();
+        }
+    }
+
+    CheckpointReader memorySection = find("MEM ");
+    std::vector<uint8_t> image = memorySection.readBytes();
+    std::vector<uint8_t> &memory = memoryHierarchy->getMainMemory()->getRawMemory();
+    if (image.size() != memory.size()) {
+        throw std::runtime_error("Checkpoint memory is " + std::to_string(image.size()) +
+                                 " bytes, simulator memory is " + std::to_string(memory.size()));
+    }
+
+    CheckpointReader spmSection = find("SPM ");
+    std::vector<std::vector<uint8_t>> scratchpads(cores.size());
+    for (size_t i = 0; i < cores.size(); i++) {
+        scratchpads[i] = spmSection.readBytes();
+        // A smaller scratchpad is fine as long as nothing was stored past its end
+        size_t size = memoryHierarchy->getSPM(static_cast<int>(i))->getRawMemory().size();
+        if (scratchpads[i].size() > size) {
+            if (std::any_of(scratchpads[i].begin() + size, scratchpads[i].end(),
+                            [](uint8_t byte) { return byte != 0; })) {
+                throw std::runtime_error("Checkpoint scratchpad of core " + std::to_string(i) +
+                                         " does not fit the configured scratchpad");
+            }
+            scratchpads[i].resize(size);
+        }
+    }
+
+    CheckpointReader syncSection = find("SYNC");
+    syncMechanism->loadState(syncSection);
+
+    memoryHierarchy->discardCaches();
+    memory = image;
+    for (size_t i = 0; i < cores.size(); i++) {
+        std::vector<uint8_t> &spm = memoryHierarchy->getSPM(static_cast<int>(i))->getRawMemory();
+        std::fill(spm.begin(), spm.end(), 0);
+        std::copy(scratchpads[i].begin(), scratchpads[i].end(), spm.begin());
+        cores[i].loadArchitecturalState(pcs[i], registers[i], halted[i]);
+    }
+
+    int restored = 0;
+    int cold = 0;
+    for (auto &section: sections) {
+        if (section.first != "CACH") {
+            continue;   // CORE/MEM/SPM/SYNC are done, END and unknown tags are skipped
+        }
+        uint8_t type = section.second.read<uint8_t>();
+        int32_t index = section.second.read<int32_t>();
+        Cache *cache = checkpointCache(type, index);
+        if (cachesUsable && cache && cache->loadState(section.second)) {
+            restored++;
+        } else {
+            cold++;
+        }
+    }
+    if (cold > 0) {
+        // Memory already holds every dirty line, so a cold cache only costs misses
+        std::cout << cold << " cache(s) in the checkpoint do not match the current configuration"
+                  << " and start cold\n";
+    }
+    std::cout << "Checkpoint restored from " << filename << " (" << restored << " cache(s) warm)\n";
+}
+
 void PipelinedSimulator::run() {
+    simulate();
+    printState();
+    printStatistics();
+}
+
+void PipelinedSimulator::simulate() {
     std::vector<bool> coreHalted(cores.size(), false);
     std::vector<bool>  coreDraining(cores.size(), false);
 
     if (memoryHierarchy) {
         memoryHierarchy->resetStatistics();
+        if (!memoryTraceFile.empty()) {
+            memoryTrace = std::make_unique<MemoryTraceWriter>(
+                memoryTraceFile, getNumCores(), [this](int coreId) { return cores[coreId].getCycleCount(); });
+            memoryHierarchy->setTraceRecorder(memoryTrace.get());
+        }
     }
-    centralizedFetch(cores, program);
-
-    while (true) {
-        bool allCoresHalted = true;
-
-       // centralizedFetch(cores, program);
+    // In exact mode threads wait for each other every cycle; with more threads
+    // than CPUs they would wait for the scheduler instead
+    int threads = hostThreads;
+    int hostCpus = static_cast<int>(std::thread::hardware_concurrency());
+    if (quantum == 1 && threads > 1 && hostCpus > 0 && threads > hostCpus) {
+        std::cout << "Host has " << hostCpus << " CPU(s); using " << hostCpus << " thread(s)\n";
+        threads = hostCpus;
+    }
+    if (threads > 1 || quantum > 1) {
+        ParallelEngine engine(cores, program, threads, quantum);
+        engine.run();
+    } else {
+        // Cycles a core has already been accounted for while idle
+        std::vector<int> idleAhead(cores.size(), 0);
+        centralizedFetch(cores, program);
+
+        while (true) {
+            bool allCoresHalted = true;
+
+           // centralizedFetch(cores, program);
+
+            for (size_t coreId = 0; coreId < cores.size(); coreId++) {
+                if (!coreHalted[coreId]) {
+                    if (idleAhead[coreId] > 0) {
+                        idleAhead[coreId]--;
+                        allCoresHalted = false;
+                        continue;
+                    }
+                    int idle = cores[coreId].skipIdleCycles();
+                    if (idle > 0) {
+                        idleAhead[coreId] = idle - 1;
+                        allCoresHalted = false;
+                        continue;
+                    }
+                    cores[coreId].clockCycle();
+
+                    if (cores[coreId].isHalted() || cores[coreId].isPipelineEmpty()) {
+                        coreHalted[coreId] = true;
+                    }
+                    else {
+                        allCoresHalted = false;
+                    }
+                }
+            }
+           centralizedFetch(cores, program);
 
-        for (size_t coreId = 0; coreId < cores.size(); coreId++) {
-            if (!coreHalted[coreId]) {
-                cores[coreId].clockCycle();
+            if (allCoresHalted)
+                break;
 
-                if (cores[coreId].isHalted() || cores[coreId].isPipelineEmpty()) {
-                    coreHalted[coreId] = true;
-                }
-                else {
-                    allCoresHalted = false;
+            auto running = [&](size_t coreId) { return !coreHalted[coreId]; };
+            int idleForAll = idleCyclesForAll(cores, program, idleAhead, running);
+            for (size_t coreId = 0; coreId < cores.size() && idleForAll > 0; coreId++) {
+                if (running(coreId)) {
+                    idleAhead[coreId] -= idleForAll;
                 }
             }
         }
-       centralizedFetch(cores, program);
-
-        if (allCoresHalted)
-            break;
     }
     // for (size_t i = 0; i < cores.size(); i++) {
     //     memoryHierarchy->getL1D(i)->flushCache();    // ensure write-back of every dirty line
@@ -297,9 +697,177 @@ void PipelinedSimulator::run() {
     if (memoryHierarchy) {
                memoryHierarchy->flushCache();
             }
+    if (memoryTrace) {
+        memoryHierarchy->setTraceRecorder(nullptr);
+        memoryTrace->finish();
+        std::cout << "Memory trace: " << memoryTrace->getEventCount() << " accesses written to "
+                  << memoryTraceFile << "\n";
+        memoryTrace.reset();
+    }
 
-    printState();
-    printStatistics();
+    finishTraces();
+}
+
+std::vector<int> PipelinedSimulator::getCycleCounts() const {
+    std::vector<int> counts;
+    for (const auto &core: cores) {
+        counts.push_back(core.getCycleCount());
+    }
+    return counts;
+}
+
+uint64_t PipelinedSimulator::getTotalInstructions() const {
+    uint64_t total = 0;
+    for (const auto &core: cores) {
+        total += core.getInstructionCount();
+    }
+    return total;
+}
+
+uint64_t PipelinedSimulator::getTotalStalls() const {
+    uint64_t total = 0;
+    for (const auto &core: cores) {
+        total += core.getStallCount();
+    }
+    return total;
+}
+
+uint64_t PipelinedSimulator::getTotalMemoryStalls() const {
+    uint64_t total = 0;
+    for (const auto &core: cores) {
+        total += core.getMemoryStallCycles();
+    }
+    return total;
+}
+
+void PipelinedSimulator::finishTraces() {
+    for (auto &core: cores) {
+        core.finishTrace();
+    }
+}
+
+MemoryHierarchy::CacheStats PipelinedSimulator::cacheTotals(MemoryHierarchy::CacheType type) const {
+    if (type == MemoryHierarchy::CacheType::L2) {
+        return memoryHierarchy->getCacheStats(type);
+    }
+    MemoryHierarchy::CacheStats total{0, 0, 0};
+    for (size_t i = 0; i < cores.size(); i++) {
+        auto stats = memoryHierarchy->getCacheStats(type, static_cast<int>(i));
+        total.accesses += stats.accesses;
+        total.hits += stats.hits;
+        total.misses += stats.misses;
+    }
+    return total;
+}
+
+DetailedWindowResult PipelinedSimulator::runDetailedWindow(uint64_t warmupInstructions,
+                                                           uint64_t measuredInstructions) {
+    if (!decodedProgram) {
+        throw std::logic_error("No program loaded");
+    }
+    if (!memoryHierarchy) {
+        throw std::logic_error("Detailed windows need the memory hierarchy");
+    }
+
+    const int programSize = static_cast<int>(decodedProgram->size());
+    auto isStopped = [&](const PipelinedCore &core) {
+        return core.isHalted() || (core.isPipelineEmpty() && core.getPC() >= programSize);
+    };
+
+    std::vector<uint64_t> startCount;
+    for (auto &core: cores) {
+        startCount.push_back(core.getInstructionCount());
+        core.fetchEnabled = true;
+    }
+    auto totalRetired = [&]() {
+        uint64_t total = 0;
+        for (const auto &core: cores) {
+            total += core.getInstructionCount();
+        }
+        return total;
+    };
+    // Every core that can still run has retired at least target instructions
+    auto reached = [&](uint64_t target) {
+        for (size_t i = 0; i < cores.size(); i++) {
+            if (!isStopped(cores[i]) && cores[i].getInstructionCount() - startCount[i] < target) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    enum class Phase { WARMUP, MEASURE, DRAIN };
+    Phase phase = Phase::WARMUP;
+    DetailedWindowResult result;
+    uint64_t cycle = 0;
+    uint64_t measureStartCycle = 0;
+    uint64_t measureStartInstructions = 0;
+    MemoryHierarchy::CacheStats startL1I{}, startL1D{}, startL2{};
+
+    auto delta = [](const MemoryHierarchy::CacheStats &end, const MemoryHierarchy::CacheStats &begin) {
+        return MemoryHierarchy::CacheStats{end.accesses - begin.accesses, end.hits - begin.hits,
+                                           end.misses - begin.misses};
+    };
+
+    uint64_t lastRetired = totalRetired();
+    int idleCycles = 0;
+    centralizedFetch(cores, program);
+
+    while (true) {
+        if (phase == Phase::WARMUP && reached(warmupInstructions)) {
+            phase = Phase::MEASURE;
+            measureStartCycle = cycle;
+            measureStartInstructions = totalRetired();
+            startL1I = cacheTotals(MemoryHierarchy::CacheType::L1I);
+            startL1D = cacheTotals(MemoryHierarchy::CacheType::L1D);
+            startL2 = cacheTotals(MemoryHierarchy::CacheType::L2);
+        }
+        if (phase == Phase::MEASURE && reached(warmupInstructions + measuredInstructions)) {
+            phase = Phase::DRAIN;
+            result.measuredCycles = cycle - measureStartCycle;
+            result.measuredInstructions = totalRetired() - measureStartInstructions;
+            result.l1i = delta(cacheTotals(MemoryHierarchy::CacheType::L1I), startL1I);
+            result.l1d = delta(cacheTotals(MemoryHierarchy::CacheType::L1D), startL1D);
+            result.l2 = delta(cacheTotals(MemoryHierarchy::CacheType::L2), startL2);
+        }
+        if (phase == Phase::DRAIN) {
+            // Only cores that still owe an arrival at an open barrier may fetch
+            bool barrierOpen = syncMechanism->isPending();
+            for (size_t i = 0; i < cores.size(); i++) {
+                cores[i].fetchEnabled = barrierOpen && !syncMechanism->hasArrived(static_cast<int>(i));
+            }
+        }
+
+        bool anyActive = false;
+        for (auto &core: cores) {
+            bool drained = phase == Phase::DRAIN && core.isPipelineEmpty() && !core.fetchEnabled;
+            if (!isStopped(core) && !drained) {
+                core.clockCycle();
+                anyActive = true;
+            }
+        }
+        if (!anyActive) {
+            break;
+        }
+        centralizedFetch(cores, program);
+        cycle++;
+
+        uint64_t retired = totalRetired();
+        if (retired != lastRetired) {
+            lastRetired = retired;
+            idleCycles = 0;
+        } else if (++idleCycles > MAX_IDLE_CYCLES) {
+            throw std::runtime_error("Detailed window made no progress for " +
+                                     std::to_string(MAX_IDLE_CYCLES) + " cycles");
+        }
+    }
+
+    for (size_t i = 0; i < cores.size(); i++) {
+        cores[i].fetchEnabled = true;
+        result.retired.push_back(cores[i].getInstructionCount() - startCount[i]);
+        result.stopped.push_back(isStopped(cores[i]));
+    }
+    return result;
 }
 
 bool PipelinedSimulator::isExecutionComplete() const {
@@ -329,7 +897,16 @@ void PipelinedSimulator::printState() const {
             if (i == 31) std::cout << " (core_id)";
             std::cout << "\n";
         }
-        core.exportPipelineRecord("pipeline_core" + std::to_string(core.getCoreId()) + ".csv");
+        if (tracePrefix.empty()) {
+            continue;
+        }
+        std::string recordName = tracePrefix + std::to_string(core.getCoreId());
+        if (core.getCycleCount() <= MAX_CSV_EXPORT_CYCLES) {
+            core.exportPipelineRecord(recordName + ".csv");
+        } else {
+            std::cout << "Pipeline trace written to " << recordName << ".trace ("
+                      << core.getCycleCount() << " cycles); convert a window with trace_to_csv\n";
+        }
     }
 
     const auto &bytes = memoryHierarchy->getRawMemory();
@@ -9,23 +9,133 @@
 #include "shared_memory.hpp"
 #include "memory_hierarchy.hpp"
 #include "sync_mechanism.hpp"
+#include "functional_engine.hpp"
+#include "memory_trace.hpp"
+
+// Per-core outcome of PipelinedSimulator::fastForward
+struct FastForwardSummary {
+    std::vector<uint64_t> instructions;
+    std::vector<FunctionalStop> stops;
+    std::vector<int> pcs;
+    double seconds = 0.0;
+    bool warmCaches = false;
+};
+
+// Outcome of PipelinedSimulator::runDetailedWindow
+struct DetailedWindowResult {
+    std::vector<uint64_t> retired;      // per core: warm-up, measured part and drain
+    std::vector<bool> stopped;          // per core: halted or ran past the program
+    uint64_t measuredCycles = 0;
+    uint64_t measuredInstructions = 0;  // all cores
+    MemoryHierarchy::CacheStats l1i{}, l1d{}, l2{};  // measured part, summed over cores
+};
 
 class PipelinedSimulator {
 public:
+    // The dense pipeline CSV grows with instructions x cycles, so it is only written
+    // automatically for short runs; longer ones use trace_to_csv with a cycle window
+    static constexpr int MAX_CSV_EXPORT_CYCLES = 5000;
+    // A detailed window with no retirement for this long is stuck (e.g. a
+    // barrier waiting for a halted core)
+    static constexpr int MAX_IDLE_CYCLES = 1000000;
+
     PipelinedSimulator(int numCores, bool enableForwarding = true);
     
     void loadProgramFromFile(const std::string& filename);
     void loadProgram(const std::string& assembly);
     
     void loadCacheConfig(const std::string& filename);
+    // Like loadCacheConfig, but throws std::invalid_argument instead of keeping
+    // the previous hierarchy when a cache cannot be built. Load the program
+    // afterwards: its data goes to the new main memory.
+    void setCacheConfig(const CacheConfig& config);
     
     void setForwardingEnabled(bool enabled);
     bool isForwardingEnabled() const;
     
+    // Occupancy limit of every stage queue. Only Pipeline::DEFAULT_STAGE_CAPACITY
+    // is accepted for now (see Pipeline::checkStageCapacity); throws
+    // std::invalid_argument for anything else.
+    void setStageCapacity(int capacity);
+    int getStageCapacity() const;
+
     void setInstructionLatency(const std::string& instruction, int latency);
     int getInstructionLatency(const std::string& instruction) const;
+
+    // Jumping over cycles in which every core only waits on memory or a
+    // barrier (PipelinedCore::skipIdleCycles); on by default. Results are the
+    // same either way.
+    void setIdleSkipping(bool enabled);
+    bool isIdleSkipping() const { return idleSkipping; }
+
+    // Host threads clocking the cores in run(); results do not depend on it.
+    // Throws std::invalid_argument for less than 1.
+    void setHostThreads(int threads);
+    int getHostThreads() const { return hostThreads; }
+
+    // Simulated cycles each core runs between synchronizations of the host
+    // threads. 1 is exact; larger values trade timing accuracy for speed (see
+    // ParallelEngine). Throws std::invalid_argument for less than 1.
+    void setQuantum(int cycles);
+    int getQuantum() const { return quantum; }
+
+    // Core i's pipeline trace and CSV are <prefix><i>.trace and <prefix><i>.csv
+    // (default prefix "pipeline_core"); an empty prefix writes neither. Takes
+    // effect when the next program is loaded.
+    void setTracePrefix(const std::string& prefix);
+    const std::string& getTracePrefix() const { return tracePrefix; }
+
+    // Records every memory-hierarchy access of the next simulate() into a
+    // binary memory trace for MemoryTraceReplay; empty (the default) records
+    // nothing.
+    void setMemoryTraceFile(const std::string& path) { memoryTraceFile = path; }
+    const std::string& getMemoryTraceFile() const { return memoryTraceFile; }
     
+    // Executes the program functionally (no timing) from the cores' current
+    // state until each core hits the instruction limit, the stop label, a halt
+    // or the end of the program, then hands the state to the pipelined cores so
+    // run() continues in detailed mode from there. Throws std::invalid_argument
+    // for an unknown label and std::logic_error if a pipeline is not empty.
+    FastForwardSummary fastForward(const FastForwardOptions& options);
+    void printFastForwardSummary(const FastForwardSummary& summary) const;
+
+    // Writes the architectural state (registers, PCs, memory with every dirty
+    // cache line folded in, scratchpads, barrier) to a versioned file, plus the
+    // cache contents when includeCaches is set. The pipelines must be empty,
+    // i.e. at program start or right after a fast-forward.
+    // Throws std::logic_error / std::runtime_error.
+    void saveCheckpoint(const std::string& filename, bool includeCaches) const;
+    // Restores a checkpoint taken with the same program and core count. Caches
+    // whose geometry differs from the current configuration start cold, as do
+    // all caches when a tag-only checkpoint is restored into a data hierarchy.
+    // Throws std::runtime_error for a bad, mismatched or unreadable file.
+    void restoreCheckpoint(const std::string& filename);
+
+    // simulate() and then the final state and statistics
     void run();
+    // Clocks the cores until every one halts or drains, then writes all dirty
+    // cache lines back and ends the traces; prints no report
+    void simulate();
+
+    // Runs the pipelined cores from their current state: first until every core
+    // has retired warmupInstructions (not measured), then another
+    // measuredInstructions (measured), then stops fetching and drains so the
+    // cores hold plain architectural state again. A core that is still due to
+    // reach a pending barrier keeps fetching until it gets there.
+    // Throws std::runtime_error if no instruction retires for MAX_IDLE_CYCLES.
+    DetailedWindowResult runDetailedWindow(uint64_t warmupInstructions, uint64_t measuredInstructions);
+
+    // Ends the binary pipeline trace of every core
+    void finishTraces();
+
+    int getNumCores() const { return static_cast<int>(cores.size()); }
+    const PipelinedCore& getCore(int coreId) const { return cores.at(coreId); }
+    std::vector<int> getCycleCounts() const;
+    uint64_t getTotalInstructions() const;
+    uint64_t getTotalStalls() const;
+    uint64_t getTotalMemoryStalls() const;
+    // Since the start of the last run; L1 caches summed over cores
+    MemoryHierarchy::CacheStats cacheTotals(MemoryHierarchy::CacheType type) const;
     
     void printState() const;
     void printStatistics() const;
@@ -33,15 +143,28 @@ public:
     bool isExecutionComplete() const;
     
 private:
+    void useMemoryHierarchy(std::shared_ptr<MemoryHierarchy> hierarchy);
+    uint64_t programHash() const;
+    Cache* checkpointCache(uint8_t type, int index) const;
+
     std::vector<PipelinedCore> cores;
     //std::shared_ptr<SharedMemory> sharedMemory;
     std::shared_ptr<MemoryHierarchy> memoryHierarchy;
     std::shared_ptr<SyncMechanism> syncMechanism;
     
-    std::vector<std::string> program;
+    std::vector<std::string> program;   // source text per PC, kept for tracing only
+    std::shared_ptr<const std::vector<Instruction>> decodedProgram;
     std::unordered_map<std::string, int> labelMap;
     std::unordered_map<std::string, int> instructionLatencies;
+    FunctionalEngine functionalEngine;
     bool forwardingEnabled;
+    int stageCapacity = Pipeline::DEFAULT_STAGE_CAPACITY;
+    bool idleSkipping = true;
+    int hostThreads = 1;
+    int quantum = 1;
+    std::string tracePrefix = "pipeline_core";
+    std::string memoryTraceFile;
+    std::unique_ptr<MemoryTraceWriter> memoryTrace;
 };
 
 #endif // PIPELINED_SIMULATOR_HPP
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef REGISTER_SCOREBOARD_HPP
+#define REGISTER_SCOREBOARD_HPP
+
+#include <array>
+
+// Per-core register status, updated as instructions move through the pipeline so
+// hazard and forwarding questions are answered by indexing instead of queue scans.
+struct RegisterScoreboard {
+    static constexpr int NUM_REGISTERS = 32;
+
+    // In-flight instructions (decode through writeback) that will write each register
+    std::array<int, NUM_REGISTERS> pendingWriters;
+    // Cycle from which a register value may be read without forwarding (-1 = always)
+    std::array<int, NUM_REGISTERS> readyCycle;
+    // Oldest in-flight producer that already has its result, and that result
+    std::array<int, NUM_REGISTERS> producerId;
+    std::array<int, NUM_REGISTERS> forwardedValue;
+    // Writes retired this cycle that land in the register file at end of cycle
+    // (forwarding disabled)
+    std::array<bool, NUM_REGISTERS> pendingWriteValid;
+    std::array<int, NUM_REGISTERS> pendingWriteValue;
+
+    RegisterScoreboard() { reset(); }
+
+    static bool isValidRegister(int reg) {
+        return reg >= 0 && reg < NUM_REGISTERS;
+    }
+
+    void reset() {
+        pendingWriters.fill(0);
+        readyCycle.fill(-1);
+        producerId.fill(-1);
+        forwardedValue.fill(0);
+        pendingWriteValid.fill(false);
+        pendingWriteValue.fill(0);
+    }
+
+    bool hasForwardedValue(int reg) const {
+        return isValidRegister(reg) && producerId[reg] >= 0;
+    }
+
+    bool isReadyAt(int reg, int cycle) const {
+        return !isValidRegister(reg) || cycle >= readyCycle[reg];
+    }
+
+    bool hasPendingWrite(int reg) const {
+        return isValidRegister(reg) && pendingWriteValid[reg];
+    }
+};
+
+#endif // REGISTER_SCOREBOARD_HPP
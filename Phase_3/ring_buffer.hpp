@@ -0,0 +1,97 @@
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+
+// Fixed-capacity double-ended queue used for the pipeline stage queues.
+// Storage is allocated once when the capacity is set; pushes and pops never allocate.
+template <typename T>
+class RingBuffer {
+public:
+    class const_iterator {
+    public:
+        const_iterator(const RingBuffer* buffer, size_t index) : buffer(buffer), index(index) {}
+        const T& operator*() const { return (*buffer)[index]; }
+        const T* operator->() const { return &(*buffer)[index]; }
+        const_iterator& operator++() { ++index; return *this; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+    private:
+        const RingBuffer* buffer;
+        size_t index;
+    };
+
+    explicit RingBuffer(size_t capacity = 0) { setCapacity(capacity); }
+
+    RingBuffer(const RingBuffer& other) : RingBuffer(other.cap) {
+        for (const auto& item : other) push_back(item);
+    }
+
+    RingBuffer& operator=(const RingBuffer& other) {
+        if (this != &other) {
+            setCapacity(other.cap);
+            for (const auto& item : other) push_back(item);
+        }
+        return *this;
+    }
+
+    RingBuffer(RingBuffer&&) noexcept = default;
+    RingBuffer& operator=(RingBuffer&&) noexcept = default;
+
+    // Reallocates the storage and drops any queued entries
+    void setCapacity(size_t capacity) {
+        storage.reset(capacity > 0 ? new T[capacity] : nullptr);
+        cap = capacity;
+        head = 0;
+        count = 0;
+    }
+
+    size_t capacity() const { return cap; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == cap; }
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+    void push_back(const T& item) {
+        if (full()) throw std::overflow_error("RingBuffer capacity exceeded");
+        storage[wrap(head + count)] = item;
+        count++;
+    }
+
+    void push_front(const T& item) {
+        if (full()) throw std::overflow_error("RingBuffer capacity exceeded");
+        head = (head == 0) ? cap - 1 : head - 1;
+        storage[head] = item;
+        count++;
+    }
+
+    void pop_front() {
+        head = wrap(head + 1);
+        count--;
+    }
+
+    T& front() { return storage[head]; }
+    const T& front() const { return storage[head]; }
+
+    T& operator[](size_t index) { return storage[wrap(head + index)]; }
+    const T& operator[](size_t index) const { return storage[wrap(head + index)]; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, count); }
+
+private:
+    std::unique_ptr<T[]> storage;
+    size_t cap = 0;
+    size_t head = 0;
+    size_t count = 0;
+
+    size_t wrap(size_t index) const { return index >= cap ? index - cap : index; }
+};
+
+#endif // RING_BUFFER_HPP
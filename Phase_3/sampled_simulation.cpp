@@ -0,0 +1,247 @@
+#include "sampled_simulation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+SampledSimulation::SampledSimulation(PipelinedSimulator &simulator, const SamplingOptions &options)
+    : simulator(simulator), options(options) {
+}
+
+double SampledSimulation::studentT95(int degreesOfFreedom) {
+    // Two-sided 95% quantiles of Student's t; the normal value beyond 30
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (degreesOfFreedom < 1) {
+        return 0.0;
+    }
+    return degreesOfFreedom <= 30 ? table[degreesOfFreedom - 1] : 1.960;
+}
+
+SampledSimulation::Estimate SampledSimulation::estimate(const std::vector<double> &values) {
+    Estimate result;
+    result.samples = static_cast<int>(values.size());
+    if (values.empty()) {
+        return result;
+    }
+    double sum = 0.0;
+    for (double v: values) {
+        sum += v;
+    }
+    result.mean = sum / values.size();
+    if (values.size() > 1) {
+        double squares = 0.0;
+        for (double v: values) {
+            squares += (v - result.mean) * (v - result.mean);
+        }
+        double stddev = std::sqrt(squares / (values.size() - 1));
+        result.halfWidth = studentT95(result.samples - 1) * stddev / std::sqrt(values.size());
+    }
+    return result;
+}
+
+bool SampledSimulation::allDone() const {
+    return std::all_of(coreDone.begin(), coreDone.end(), [](bool done) { return done; });
+}
+
+uint64_t SampledSimulation::position() const {
+    uint64_t furthest = 0;
+    for (size_t i = 0; i < executed.size(); i++) {
+        if (!coreDone[i]) {
+            furthest = std::max(furthest, executed[i]);
+        }
+    }
+    return furthest;
+}
+
+void SampledSimulation::fastForward(uint64_t instructions, bool warmCaches) {
+    if (instructions == 0) {
+        return;
+    }
+    runFunctional(instructions, warmCaches);
+}
+
+void SampledSimulation::runFunctional(uint64_t instructions, bool warmCaches) {
+    FastForwardOptions ffOptions;
+    ffOptions.maxInstructions = instructions;   // 0 runs to the end
+    ffOptions.warmCaches = warmCaches;
+    FastForwardSummary summary = simulator.fastForward(ffOptions);
+
+    for (size_t i = 0; i < executed.size(); i++) {
+        executed[i] += summary.instructions[i];
+        functionalInstructions += summary.instructions[i];
+        coreDone[i] = summary.stops[i] == FunctionalStop::HALTED ||
+                      summary.stops[i] == FunctionalStop::END_OF_PROGRAM;
+    }
+}
+
+void SampledSimulation::detailedWindow(uint64_t detailedWarmup) {
+    uint64_t start = position();
+    DetailedWindowResult window = simulator.runDetailedWindow(detailedWarmup, options.measuredInstructions);
+
+    for (size_t i = 0; i < executed.size(); i++) {
+        executed[i] += window.retired[i];
+        detailedInstructions += window.retired[i];
+        coreDone[i] = window.stopped[i];
+    }
+    // A window cut short by the end of the program is still a valid sample
+    if (window.measuredInstructions > 0 && window.measuredCycles > 0) {
+        samples.push_back(Sample{start + detailedWarmup, window.measuredCycles,
+                                 window.measuredInstructions, window.l1i, window.l1d, window.l2});
+    }
+}
+
+void SampledSimulation::run() {
+    const uint64_t window = options.functionalWarmup + options.detailedWarmup + options.measuredInstructions;
+    if (options.measuredInstructions == 0) {
+        throw std::invalid_argument("Sampling needs a measured window of at least one instruction");
+    }
+    if (options.samplePoints.empty() && options.period < window) {
+        throw std::invalid_argument("Sampling period " + std::to_string(options.period) +
+                                    " is shorter than warm-up plus measured window (" +
+                                    std::to_string(window) + ")");
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    int numCores = simulator.getNumCores();
+    executed.assign(numCores, 0);
+    coreDone.assign(numCores, false);
+    samples.clear();
+    functionalInstructions = 0;
+    detailedInstructions = 0;
+
+    if (options.samplePoints.empty()) {
+        // Systematic sampling: the measured window sits at the end of every period
+        while (!allDone()) {
+            uint64_t before = position();
+            fastForward(options.period - window, false);
+            if (allDone()) break;
+            fastForward(options.functionalWarmup, true);
+            if (allDone()) break;
+            detailedWindow(options.detailedWarmup);
+            // A barrier that can never open (a core halted before it) stops everything
+            if (position() == before) break;
+        }
+    } else {
+        std::vector<uint64_t> points = options.samplePoints;
+        std::sort(points.begin(), points.end());
+        for (uint64_t point: points) {
+            if (allDone()) break;
+            // Warm-up is cut short when the previous window ran past it
+            uint64_t lead = options.functionalWarmup + options.detailedWarmup;
+            uint64_t warmStart = point > lead ? point - lead : 0;
+            if (warmStart > position()) {
+                fastForward(warmStart - position(), false);
+            }
+            uint64_t detailedStart = point > options.detailedWarmup ? point - options.detailedWarmup : 0;
+            if (!allDone() && detailedStart > position()) {
+                fastForward(detailedStart - position(), true);
+            }
+            if (!allDone()) {
+                detailedWindow(point > position() ? point - position() : 0);
+            }
+        }
+        if (!allDone()) {
+            runFunctional(0, false);
+        }
+    }
+
+    simulator.finishTraces();
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void SampledSimulation::printCacheEstimate(const char *name, MemoryHierarchy::CacheStats Sample::*level,
+                                           uint64_t totalInstructions) const {
+    std::vector<double> missRates;
+    std::vector<double> mpki;
+    for (const auto &sample: samples) {
+        const MemoryHierarchy::CacheStats &stats = sample.*level;
+        if (stats.accesses > 0) {
+            missRates.push_back(static_cast<double>(stats.misses) / stats.accesses);
+        }
+        mpki.push_back(stats.misses * 1000.0 / sample.instructions);
+    }
+    Estimate rate = estimate(missRates);
+    Estimate perKilo = estimate(mpki);
+
+    std::cout << "  " << name << ": miss rate " << std::setprecision(2)
+              << rate.mean * 100.0 << "% +/- " << rate.halfWidth * 100.0 << "%"
+              << ", MPKI " << perKilo.mean << " +/- " << perKilo.halfWidth
+              << ", estimated misses " << std::setprecision(0)
+              << perKilo.mean * totalInstructions / 1000.0 << "\n";
+}
+
+void SampledSimulation::printReport() const {
+    uint64_t totalInstructions = functionalInstructions + detailedInstructions;
+
+    std::cout << "\n=== Sampled Simulation ===\n";
+    std::cout << "Samples: " << samples.size() << " x " << options.measuredInstructions
+              << " measured instructions per core";
+    if (options.samplePoints.empty()) {
+        std::cout << ", one every " << options.period;
+    }
+    std::cout << "\n";
+    std::cout << "Warm-up per sample: " << options.functionalWarmup << " functional (caches), "
+              << options.detailedWarmup << " detailed\n";
+    std::cout << "Instructions: " << totalInstructions << " total, " << detailedInstructions
+              << " detailed (" << std::fixed << std::setprecision(2)
+              << (totalInstructions > 0 ? detailedInstructions * 100.0 / totalInstructions : 0.0)
+              << "%)\n";
+    std::cout << "Wall time: " << std::setprecision(3) << seconds << " s\n";
+
+    if (samples.empty()) {
+        std::cout << "No detailed window was measured; nothing to extrapolate\n";
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+        return;
+    }
+
+    std::vector<double> cpi;
+    for (const auto &sample: samples) {
+        cpi.push_back(static_cast<double>(sample.cycles) / sample.instructions);
+    }
+    Estimate cpiEstimate = estimate(cpi);
+
+    // Cycles are shared by all cores, so CPI here is cycles per instruction of
+    // the whole machine and IPC matches "Overall IPC" of a detailed run
+    double cycles = cpiEstimate.mean * totalInstructions;
+    double cyclesHalfWidth = cpiEstimate.halfWidth * totalInstructions;
+    double ipc = cpiEstimate.mean > 0 ? 1.0 / cpiEstimate.mean : 0.0;
+    double ipcLow = 1.0 / (cpiEstimate.mean + cpiEstimate.halfWidth);
+    double ipcHigh = cpiEstimate.mean > cpiEstimate.halfWidth
+                         ? 1.0 / (cpiEstimate.mean - cpiEstimate.halfWidth) : INFINITY;
+
+    std::cout << "\nEstimates (95% confidence):\n";
+    if (samples.size() < 2) {
+        std::cout << "  (a single sample has no spread; the intervals below are not meaningful)\n";
+    }
+    std::cout << "  Cycles: " << std::setprecision(0) << cycles << " +/- " << cyclesHalfWidth;
+    if (cycles > 0) {
+        std::cout << " (" << std::setprecision(2) << cyclesHalfWidth * 100.0 / cycles << "%)";
+    }
+    std::cout << "\n";
+    std::cout << "  Overall IPC: " << std::setprecision(3) << ipc
+              << " [" << ipcLow << ", " << ipcHigh << "]\n";
+
+    if (cpiEstimate.samples > 1 && cpiEstimate.mean > 0) {
+        // Samples needed for +/-3% at 95% confidence with the observed variation
+        double variation = cpiEstimate.halfWidth / studentT95(cpiEstimate.samples - 1) *
+                           std::sqrt(cpiEstimate.samples) / cpiEstimate.mean;
+        double needed = std::ceil(std::pow(1.96 * variation / 0.03, 2));
+        std::cout << "  CPI coefficient of variation: " << std::setprecision(3) << variation
+                  << " (about " << std::setprecision(0) << needed << " samples for +/-3%)\n";
+    }
+
+    std::cout << "\nCache estimates (95% confidence):\n";
+    printCacheEstimate("L1I", &Sample::l1i, totalInstructions);
+    printCacheEstimate("L1D", &Sample::l1d, totalInstructions);
+    printCacheEstimate("L2", &Sample::l2, totalInstructions);
+
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
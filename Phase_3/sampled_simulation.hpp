@@ -0,0 +1,68 @@
+#ifndef SAMPLED_SIMULATION_HPP
+#define SAMPLED_SIMULATION_HPP
+
+#include <cstdint>
+#include <vector>
+#include "pipelined_simulator.hpp"
+
+// Instruction counts are per core, like the fast-forward limit
+struct SamplingOptions {
+    uint64_t period = 1000000;          // one sample every period instructions
+    std::vector<uint64_t> samplePoints; // measured windows start here instead (if any)
+    uint64_t functionalWarmup = 50000;  // functional instructions with cache warming
+    uint64_t detailedWarmup = 2000;     // detailed but unmeasured (fills the pipeline)
+    uint64_t measuredInstructions = 10000;
+};
+
+// Sampled simulation: runs the whole program, mostly in the functional engine,
+// and only measures short detailed windows. Before each window the caches are
+// warmed functionally and the pipeline is warmed in detail. Totals are
+// extrapolated from the per-window CPI and miss rates, with 95% confidence
+// intervals from the spread between windows.
+class SampledSimulation {
+public:
+    SampledSimulation(PipelinedSimulator& simulator, const SamplingOptions& options);
+
+    // Throws std::invalid_argument if the period cannot hold the warm-up and
+    // the measured window
+    void run();
+    void printReport() const;
+
+private:
+    struct Sample {
+        uint64_t position;              // per-core instructions before the window
+        uint64_t cycles;
+        uint64_t instructions;          // all cores
+        MemoryHierarchy::CacheStats l1i, l1d, l2;
+    };
+
+    struct Estimate {
+        double mean = 0.0;
+        double halfWidth = 0.0;         // 95% confidence
+        int samples = 0;
+    };
+
+    static double studentT95(int degreesOfFreedom);
+    static Estimate estimate(const std::vector<double>& values);
+
+    PipelinedSimulator& simulator;
+    SamplingOptions options;
+
+    std::vector<Sample> samples;
+    std::vector<uint64_t> executed;     // per core, functional and detailed
+    std::vector<bool> coreDone;
+    uint64_t functionalInstructions = 0;
+    uint64_t detailedInstructions = 0;
+    double seconds = 0.0;
+
+    bool allDone() const;
+    uint64_t position() const;
+    // fastForward does nothing for 0 instructions; runFunctional(0, ...) runs to the end
+    void fastForward(uint64_t instructions, bool warmCaches);
+    void runFunctional(uint64_t instructions, bool warmCaches);
+    void detailedWindow(uint64_t detailedWarmup);
+    void printCacheEstimate(const char* name, MemoryHierarchy::CacheStats Sample::*level,
+                            uint64_t totalInstructions) const;
+};
+
+#endif // SAMPLED_SIMULATION_HPP
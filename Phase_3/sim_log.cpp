@@ -0,0 +1,43 @@
+#include "sim_log.hpp"
+#include "assembly_lexer.hpp"
+#include <stdexcept>
+
+void SimLog::configure(const std::string &spec) {
+    uint32_t mask = 0;
+    LogLevel level = LogLevel::TRACE;
+    bool anyCategory = false;
+
+    AssemblyLexer::OperandList words;
+    size_t count = AssemblyLexer::splitOperands(spec, words);
+    for (size_t i = 0; i < count; i++) {
+        std::string_view word = words[i];
+        if (word == "none") {
+            setLevel(LogLevel::OFF);
+            return;
+        }
+        if (word == "all")         { mask |= ALL_CATEGORIES; anyCategory = true; }
+        else if (word == "fetch")  { mask |= static_cast<uint32_t>(LogCategory::FETCH);  anyCategory = true; }
+        else if (word == "decode") { mask |= static_cast<uint32_t>(LogCategory::DECODE); anyCategory = true; }
+        else if (word == "exec")   { mask |= static_cast<uint32_t>(LogCategory::EXEC);   anyCategory = true; }
+        else if (word == "mem")    { mask |= static_cast<uint32_t>(LogCategory::MEM);    anyCategory = true; }
+        else if (word == "cache")  { mask |= static_cast<uint32_t>(LogCategory::CACHE);  anyCategory = true; }
+        else if (word == "sync")   { mask |= static_cast<uint32_t>(LogCategory::SYNC);   anyCategory = true; }
+        else if (word == "info")   { level = LogLevel::INFO; }
+        else if (word == "debug")  { level = LogLevel::DEBUG; }
+        else if (word == "trace")  { level = LogLevel::TRACE; }
+        else {
+            throw std::invalid_argument("Unknown trace option '" + std::string(word) + "'");
+        }
+    }
+
+    // A bare level ("debug") applies to every category
+    if (!anyCategory) {
+        if (count == 0) {
+            setLevel(LogLevel::OFF);
+            return;
+        }
+        mask = ALL_CATEGORIES;
+    }
+    setCategories(mask);
+    setLevel(level);
+}
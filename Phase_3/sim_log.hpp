@@ -0,0 +1,82 @@
+#ifndef SIM_LOG_HPP
+#define SIM_LOG_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Tracing for the simulator's per-cycle chatter. Every message has a category
+// (the subsystem it comes from) and a level:
+//   INFO  - rare events (halt, barrier release, cache setup)
+//   DEBUG - one line per instruction per stage
+//   TRACE - raw data dumps (bytes written through the caches and to DRAM)
+// Messages above SIM_LOG_MAX_LEVEL are compiled out; the rest are filtered at
+// run time (default: INFO for every category) and their arguments are only
+// evaluated when they will be printed.
+// Errors and the end-of-run report are not tracing and keep using std::cout/cerr.
+#ifndef SIM_LOG_MAX_LEVEL
+#define SIM_LOG_MAX_LEVEL 3
+#endif
+
+enum class LogLevel : int {
+    OFF = 0,
+    INFO = 1,
+    DEBUG = 2,
+    TRACE = 3
+};
+
+enum class LogCategory : uint32_t {
+    FETCH  = 1u << 0,
+    DECODE = 1u << 1,   // includes the assembly parser
+    EXEC   = 1u << 2,
+    MEM    = 1u << 3,
+    CACHE  = 1u << 4,
+    SYNC   = 1u << 5
+};
+
+class SimLog {
+public:
+    static constexpr uint32_t ALL_CATEGORIES = 0x3F;
+
+    static bool enabled(LogCategory category, LogLevel level) {
+        return static_cast<int>(level) <= static_cast<int>(runtimeLevel) &&
+               (categoryMask & static_cast<uint32_t>(category)) != 0;
+    }
+
+    static void setLevel(LogLevel level) { runtimeLevel = level; }
+    static LogLevel getLevel() { return runtimeLevel; }
+    static void setCategories(uint32_t mask) { categoryMask = mask; }
+    static uint32_t getCategories() { return categoryMask; }
+
+    // Messages go to std::cout unless the calling thread redirected them; the
+    // parallel engine collects each core's messages and prints them in core order
+    static std::ostream& out() { return *stream; }
+    static void setStream(std::ostream* target) { stream = target ? target : &std::cout; }
+
+    // Accepts "none", "all", or a comma-separated list of category names
+    // (fetch, decode, exec, mem, cache, sync) and at most one level name
+    // (info, debug, trace). Without a level everything is printed (TRACE).
+    // Throws std::invalid_argument on an unknown word.
+    static void configure(const std::string& spec);
+
+private:
+    static inline LogLevel runtimeLevel = LogLevel::INFO;
+    static inline uint32_t categoryMask = ALL_CATEGORIES;
+    static inline thread_local std::ostream* stream = &std::cout;
+};
+
+// True when a message of this category and level would be printed; constant
+// false when the level is compiled out. Use it to guard multi-statement dumps.
+#define SIM_LOG_ENABLED(category, level)                                               \
+    (static_cast<int>(LogLevel::level) <= SIM_LOG_MAX_LEVEL &&                         \
+     SimLog::enabled(LogCategory::category, LogLevel::level))
+
+// SIM_LOG(EXEC, DEBUG, "[Core " << id << "] ...\n");
+#define SIM_LOG(category, level, message)                                              \
+    do {                                                                               \
+        if (SIM_LOG_ENABLED(category, level)) {                                        \
+            SimLog::out() << message;                                                  \
+        }                                                                              \
+    } while (0)
+
+#endif // SIM_LOG_HPP
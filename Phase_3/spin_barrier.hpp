@@ -0,0 +1,140 @@
+#ifndef SPIN_BARRIER_HPP
+#define SPIN_BARRIER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Busy-wait step for the parallel engine. A simulated cycle is far shorter
+// than a futex round trip, so waiters spin; after a while they yield so an
+// oversubscribed host (more threads than CPUs) still makes progress.
+class SpinWait {
+public:
+    static constexpr int SPINS_BEFORE_YIELD = 64;
+
+    void pause() {
+        if (++spins < SPINS_BEFORE_YIELD) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    int spins = 0;
+};
+
+// Sense-reversing barrier for a fixed number of threads. The last thread to
+// arrive runs the completion step alone before anyone is released, so the
+// serial part of a cycle needs no second barrier.
+class SpinBarrier {
+public:
+    explicit SpinBarrier(int participants) : participants(participants), remaining(participants) {}
+
+    template <typename Completion>
+    void arriveAndWait(Completion &&onComplete) {
+        uint32_t current = generation.load(std::memory_order_relaxed);
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            onComplete();
+            remaining.store(participants, std::memory_order_relaxed);
+            generation.store(current + 1, std::memory_order_release);
+            return;
+        }
+        SpinWait wait;
+        while (generation.load(std::memory_order_acquire) == current) {
+            wait.pause();
+        }
+    }
+
+private:
+    const int participants;
+    std::atomic<int> remaining;
+    std::atomic<uint32_t> generation{0};
+};
+
+// Orders the accesses cores make to shared state (L2, main memory, the sync
+// barrier, other cores' L1D) within one simulated cycle. The serial engine
+// clocks core 0 to completion, then core 1, and so on; in ORDERED mode a core
+// may run its private stages early but takes its turn before its first shared
+// access and passes it on once it is past the stages that can touch shared
+// state, so shared state sees exactly the serial order. In LOCKED mode (the
+// relaxed engine) the turn is a plain lock: one core at a time, in whatever
+// order they come.
+class SharedAccessTurn {
+public:
+    enum class Mode : uint8_t { ORDERED, LOCKED };
+
+    explicit SharedAccessTurn(int numCores, Mode mode = Mode::ORDERED)
+        : mode(mode),
+          successor(numCores, NONE),
+          stage(numCores, mode == Mode::LOCKED ? WAITING : DONE),
+          l1dPrivate(mode == Mode::LOCKED) {}
+
+    // Serial part of the cycle (ORDERED mode): order lists the cores clocked
+    // this cycle in increasing id. l1dHitsPrivate says no core can flush
+    // another core's L1D this cycle, so L1D read hits need no turn.
+    void beginCycle(const std::vector<int> &order, bool l1dHitsPrivate) {
+        for (size_t i = 0; i < order.size(); i++) {
+            successor[order[i]] = i + 1 < order.size() ? order[i + 1] : NONE;
+            stage[order[i]] = WAITING;
+        }
+        l1dPrivate = l1dHitsPrivate;
+        holder.store(order.empty() ? NONE : order.front(), std::memory_order_release);
+    }
+
+    // Blocks until every earlier core has passed its turn on (ORDERED) or the
+    // lock is free (LOCKED); no-op when held
+    void enter(int coreId) {
+        if (stage[coreId] != WAITING) {
+            return;
+        }
+        SpinWait wait;
+        if (mode == Mode::LOCKED) {
+            while (locked.exchange(true, std::memory_order_acquire)) {
+                wait.pause();
+            }
+        } else {
+            while (holder.load(std::memory_order_acquire) != coreId) {
+                wait.pause();
+            }
+        }
+        stage[coreId] = HOLDING;
+    }
+
+    // ORDERED: hands the turn to the next core (taking it first if needed);
+    // no-op after the first call in a cycle. LOCKED: releases the lock if held.
+    void leave(int coreId) {
+        if (mode == Mode::LOCKED) {
+            if (stage[coreId] == HOLDING) {
+                stage[coreId] = WAITING;
+                locked.store(false, std::memory_order_release);
+            }
+            return;
+        }
+        if (stage[coreId] == DONE) {
+            return;
+        }
+        enter(coreId);
+        stage[coreId] = DONE;
+        holder.store(successor[coreId], std::memory_order_release);
+    }
+
+    // Always true in LOCKED mode: the relaxed engine defers cross-core flushes
+    bool l1dHitsArePrivate() const { return l1dPrivate; }
+
+private:
+    static constexpr int NONE = -1;
+    enum Stage : uint8_t { WAITING, HOLDING, DONE };
+
+    const Mode mode;
+    std::atomic<int> holder{NONE};
+    std::atomic<bool> locked{false};
+    std::vector<int> successor;     // written in the serial part only
+    std::vector<uint8_t> stage;     // per core, touched only by the thread clocking it
+    bool l1dPrivate = false;
+};
+
+#endif // SPIN_BARRIER_HPP
@@ -146,6 +146,8 @@
 #include <vector>
 #include <iostream>
 #include "memory_hierarchy.hpp"
+#include "checkpoint.hpp"
+#include "sim_log.hpp"
 
 // A cycle-accurate barrier implementation for a multi-core simulator with cache coherence support
 class SyncMechanism {
@@ -165,10 +167,15 @@ public:
         retired(n, false)
     {}
 
+    // The simulator replaces its hierarchy when a cache configuration is loaded
+    void setMemoryHierarchy(MemoryHierarchy* mem) {
+        memoryHierarchy = mem;
+    }
+
     // Phase 1: Called in EX stage when a core reaches the SYNC
     void arrive(int coreId) {
         if (!arrived[coreId]) {
-            std::cout << "[Core " << coreId << "] Arrived at SYNC\n";
+            SIM_LOG(SYNC, DEBUG, "[Core " << coreId << "] Arrived at SYNC\n");
             arrived[coreId] = true;
             ++arriveCount;
         }
@@ -181,8 +188,10 @@ public:
 
     // Determine if the core can proceed past the barrier
     bool canProceed(int coreId) const {
-        // A core can proceed if all cores have arrived at the barrier
-        return allArrived();
+        // A core can proceed if all cores have arrived at the barrier. One that
+        // already retired this barrier and reaches the next sync before the last
+        // core retires waits for the reset instead of slipping through.
+        return allArrived() && !retired[coreId];
     }
 
     // Phase 2: Called when retiring the SYNC in MEM/WB stage
@@ -190,17 +199,17 @@ public:
         if (!retired[coreId]) {
             retired[coreId] = true;
             ++retireCount;
-            std::cout << "[Barrier] core " << coreId
-                     << " retired (count=" << retireCount << ")\n";
+            SIM_LOG(SYNC, DEBUG, "[Barrier] core " << coreId
+                     << " retired (count=" << retireCount << ")\n");
         }
 
         // Only clear the barrier state when all cores have retired
         if (retireCount == numCores) {
-            std::cout << "[Barrier] all cores retired—flushing L1Ds now\n";
+            SIM_LOG(SYNC, INFO, "[Barrier] all cores retired—flushing L1Ds now\n");
 
             // Flush all L1 data caches to ensure memory coherence
             for (int c = 0; c < numCores; ++c) {
-                std::cout << "[Barrier] calling flushL1D(" << c << ")\n";
+                SIM_LOG(SYNC, DEBUG, "[Barrier] calling flushL1D(" << c << ")\n");
                 // Ensure all dirty cache lines are written back to memory
                 memoryHierarchy->flushL1D(c);
             }
@@ -213,7 +222,38 @@ public:
             std::fill(retired.begin(), retired.end(), false);
             arriveCount = retireCount = 0;
 
-            std::cout << "[Barrier] Barrier reset complete\n";
+            SIM_LOG(SYNC, INFO, "[Barrier] Barrier reset complete\n");
+        }
+    }
+
+    // True between the first arrival and the last retirement of a barrier
+    bool isPending() const {
+        return arriveCount > 0 || retireCount > 0;
+    }
+
+    bool hasArrived(int coreId) const {
+        return arrived[coreId];
+    }
+
+    void saveState(CheckpointWriter& out) const {
+        out.write<int32_t>(numCores);
+        for (int c = 0; c < numCores; ++c) {
+            out.write<uint8_t>(arrived[c]);
+            out.write<uint8_t>(retired[c]);
+        }
+    }
+
+    // Throws std::runtime_error if the checkpoint has a different core count
+    void loadState(CheckpointReader& in) {
+        if (in.read<int32_t>() != numCores) {
+            throw std::runtime_error("Checkpoint barrier state is for a different core count");
+        }
+        arriveCount = retireCount = 0;
+        for (int c = 0; c < numCores; ++c) {
+            arrived[c] = in.read<uint8_t>() != 0;
+            retired[c] = in.read<uint8_t>() != 0;
+            arriveCount += arrived[c];
+            retireCount += retired[c];
         }
     }
 
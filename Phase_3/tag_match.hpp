@@ -0,0 +1,78 @@
+#ifndef TAG_MATCH_HPP
+#define TAG_MATCH_HPP
+
+#include <cstdint>
+
+// The vector paths need GCC or Clang (__builtin_ctz)
+#if defined(__GNUC__) && defined(__AVX2__)
+#define TAG_MATCH_AVX2 1
+#endif
+#if defined(__GNUC__) && defined(__SSE2__)
+#define TAG_MATCH_SSE2 1
+#include <immintrin.h>
+#endif
+
+// Searches of ways [way, ways) at one compare width each. findMatchingWay at
+// the bottom picks the widest one compiled in; they are separate functions so
+// bench/tag_match_bench.cpp can compare them.
+
+inline int findMatchingWayScalar(const uint32_t* tags, const uint8_t* valid, int ways, uint32_t tag,
+                                 int way = 0) {
+    for (; way < ways; way++) {
+        if (valid[way] && tags[way] == tag) return way;
+    }
+    return -1;
+}
+
+#ifdef TAG_MATCH_SSE2
+inline int findMatchingWaySse2(const uint32_t* tags, const uint8_t* valid, int ways, uint32_t tag,
+                               int way = 0) {
+    const __m128i wanted = _mm_set1_epi32(static_cast<int>(tag));
+    for (; way + 4 <= ways; way += 4) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + way));
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(chunk, wanted))));
+        for (; mask != 0; mask &= mask - 1) {
+            int candidate = way + __builtin_ctz(mask);
+            if (valid[candidate]) return candidate;
+        }
+    }
+    return findMatchingWayScalar(tags, valid, ways, tag, way);
+}
+#endif
+
+#ifdef TAG_MATCH_AVX2
+inline int findMatchingWayAvx2(const uint32_t* tags, const uint8_t* valid, int ways, uint32_t tag,
+                               int way = 0) {
+    const __m256i wanted = _mm256_set1_epi32(static_cast<int>(tag));
+    for (; way + 8 <= ways; way += 8) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + way));
+        unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(chunk, wanted))));
+        for (; mask != 0; mask &= mask - 1) {
+            int candidate = way + __builtin_ctz(mask);
+            if (valid[candidate]) return candidate;
+        }
+    }
+    return findMatchingWaySse2(tags, valid, ways, tag, way);
+}
+#endif
+
+// Finds the first valid way of a set whose tag equals tag, or -1. tags and
+// valid point at the set's entries in the cache's structure-of-arrays store.
+// Tags are compared 8 at a time with AVX2 (when compiled with -mavx2 or
+// -march=native) or 4 at a time with SSE2, which covers 8- and 16-way sets
+// without a scalar step; leftover ways and other targets use the scalar loop.
+// A compare only yields candidates: invalid ways keep their old tags, so each
+// match is checked against valid in way order.
+inline int findMatchingWay(const uint32_t* tags, const uint8_t* valid, int ways, uint32_t tag) {
+#if defined(TAG_MATCH_AVX2)
+    return findMatchingWayAvx2(tags, valid, ways, tag);
+#elif defined(TAG_MATCH_SSE2)
+    return findMatchingWaySse2(tags, valid, ways, tag);
+#else
+    return findMatchingWayScalar(tags, valid, ways, tag);
+#endif
+}
+
+#endif // TAG_MATCH_HPP
@@ -0,0 +1,98 @@
+// Cache reads and writes go through caller buffers and per-cache fill and
+// writeback buffers, so an access allocates nothing on the heap: neither a
+// hit nor a miss with a fill and a dirty writeback. operator new is replaced
+// here to count allocations.
+#include "cache_system.hpp"
+#include "memory_hierarchy.hpp"
+#include "sim_log.hpp"
+#include "test_support.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace {
+size_t allocations = 0;
+}
+
+void *operator new(size_t size) {
+    allocations++;
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// L1D (write-through to L2) -> L2 -> main memory built by hand, so accesses
+// take Cache::read/write and the CacheSystem word helpers
+void testCacheAccesses() {
+    auto memory = std::make_shared<MainMemory>(4096, 100);
+    auto l2 = std::make_shared<L2Cache>(1024, 64, 4, 10, ReplacementPolicy::LRU);
+    l2->setNextLevelCache(std::make_unique<MemorySystem>(memory));
+    L1DCache l1d(256, 64, 2, 1, ReplacementPolicy::LRU);
+    l1d.setNextLevelCache(std::make_unique<MemorySystem>(l2));
+
+    for (uint32_t address = 0; address < 256; address += 4) {
+        l1d.writeWord(address, static_cast<int32_t>(address));
+    }
+
+    size_t before = allocations;
+    uint64_t missesBefore = l1d.getMisses();
+    uint8_t buffer[8];
+    int64_t sum = 0;
+    for (int i = 0; i < 100000; i++) {
+        uint32_t address = (i * 4) % 256;
+        sum += l1d.readWord(address).second;
+        l1d.writeWord(address, i);
+        l1d.read(address & ~7u, buffer, 8);
+        l1d.write(address & ~7u, buffer, 8);
+    }
+    CHECK_EQ(l1d.getMisses(), missesBefore);
+    CHECK_EQ(allocations - before, size_t(0));
+
+    // Sweeping all of memory misses in both caches and writes back dirty lines
+    before = allocations;
+    for (int i = 0; i < 20000; i++) {
+        uint32_t address = (i * 4) % 4096;
+        sum += l1d.readWord(address).second;
+        l1d.writeWord((address + 2048) % 4096, i);
+    }
+    CHECK(l1d.getMisses() > missesBefore);
+    CHECK(l2->getMisses() > 0);
+    CHECK_EQ(allocations - before, size_t(0));
+    CHECK(sum != 1);  // keeps the reads
+}
+
+// The same through MemoryHierarchy: cache_config.txt takes the compiled
+// cache paths, cacheconfig (100-set L1D, FIFO L2) the dynamic ones
+void testHierarchy(const char *configFile) {
+    MemoryHierarchy hierarchy(1, configFile);
+    for (uint32_t address = 0; address < 4096; address += 4) {
+        hierarchy.storeWord(0, address, static_cast<int32_t>(address));
+        hierarchy.fetchInstruction(0, address);
+    }
+
+    size_t before = allocations;
+    int64_t sum = 0;
+    for (int i = 0; i < 100000; i++) {
+        uint32_t address = (i * 4) % 4096;
+        sum += hierarchy.loadWord(0, address).second;
+        sum += hierarchy.fetchInstruction(0, address).first;
+        hierarchy.storeWord(0, (address + 1024) % 4096, i);
+    }
+    CHECK_EQ(allocations - before, size_t(0));
+    CHECK(sum != 1);
+}
+
+} // namespace
+
+int main() {
+    SimLog::setLevel(LogLevel::OFF);
+    testCacheAccesses();
+    testHierarchy("cache_config.txt");
+    testHierarchy("cacheconfig");
+    return testResult();
+}
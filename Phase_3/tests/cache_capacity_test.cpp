@@ -0,0 +1,73 @@
+// Caches whose set count is not a power of two index every set: a cache is
+// filled with exactly as many consecutive blocks as it has lines, and reading
+// them again must not miss. FastDivisor, which computes the set index, must
+// agree with / and % on the numerators at the edges of each divisor's range.
+// Runs from the Phase_3 directory, so the hierarchy reads cacheconfig.
+#include "cache_system.hpp"
+#include "fast_divisor.hpp"
+#include "memory_hierarchy.hpp"
+#include "sim_log.hpp"
+#include "test_support.hpp"
+#include <cstdint>
+
+namespace {
+
+void testFastDivisor() {
+    for (uint32_t divisor = 2; divisor <= 4096; divisor++) {
+        FastDivisor fast(divisor);
+        const uint32_t numerators[] = {0, 1, divisor - 1, divisor, divisor + 1, 0x7fffffffu, 0x80000000u,
+                                       UINT32_MAX - 1, UINT32_MAX};
+        for (uint32_t value: numerators) {
+            if (fast.quotient(value) != value / divisor || fast.remainder(value) != value % divisor) {
+                std::cerr << value << " / " << divisor << "\n";
+                CHECK_EQ(fast.quotient(value), value / divisor);
+                CHECK_EQ(fast.remainder(value), value % divisor);
+            }
+        }
+    }
+}
+
+// A second pass over `lines` consecutive blocks only hits, and the values
+// written through the cache come back
+void testFill(int size, int blockSize, int associativity) {
+    std::cerr << size << " B, " << blockSize << " B blocks, " << associativity << "-way\n";
+    auto memory = std::make_shared<MainMemory>(64 * 1024, 10);
+    L1DCache cache(size, blockSize, associativity, 1, ReplacementPolicy::LRU);
+    cache.setNextLevelCache(std::make_unique<MemorySystem>(memory));
+
+    const uint32_t lines = size / blockSize;
+    for (uint32_t line = 0; line < lines; line++) {
+        cache.writeWord(line * blockSize, static_cast<int32_t>(line * 7 + 1));
+    }
+    uint64_t missesBefore = cache.getMisses();
+    for (uint32_t line = 0; line < lines; line++) {
+        CHECK_EQ(cache.readWord(line * blockSize).second, static_cast<int32_t>(line * 7 + 1));
+    }
+    CHECK_EQ(cache.getMisses() - missesBefore, uint64_t(0));
+}
+
+// cacheconfig's 400 B direct-mapped L1D with 4 B blocks, through the hierarchy
+void testHierarchy() {
+    MemoryHierarchy hierarchy(1, "cacheconfig");
+    for (uint32_t address = 0; address < 400; address += 4) {
+        hierarchy.loadWord(0, address);
+    }
+    uint64_t missesBefore = hierarchy.getCacheStats(MemoryHierarchy::CacheType::L1D).misses;
+    for (uint32_t address = 0; address < 400; address += 4) {
+        hierarchy.loadWord(0, address);
+    }
+    CHECK_EQ(hierarchy.getCacheStats(MemoryHierarchy::CacheType::L1D).misses - missesBefore, uint64_t(0));
+}
+
+} // namespace
+
+int main() {
+    SimLog::setLevel(LogLevel::OFF);
+    testFastDivisor();
+    testFill(400, 4, 1);     // 100 sets
+    testFill(1200, 4, 4);    // 75 sets
+    testFill(768, 64, 2);    // 6 sets
+    testFill(16384, 64, 2);  // 128 sets
+    testHierarchy();
+    return testResult();
+}
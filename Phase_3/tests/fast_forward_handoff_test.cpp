@@ -0,0 +1,55 @@
+// A linking jal must leave the same return address whichever engine runs it:
+// the functional engine links the instruction after the jal, and so must the
+// pipelined core. The program is fast-forwarded by every budget that stops
+// inside or around the loop, then finished in detailed mode.
+#include "pipelined_simulator.hpp"
+#include "sim_log.hpp"
+#include "test_support.hpp"
+
+namespace {
+
+// x1 is the link of "jal x1, body" at index 1, so 2; the body adds it to x3
+// three times
+const char *PROGRAM = R"(
+.text
+    addi x2, x0, 3
+loop:
+    jal x1, body
+    halt
+body:
+    add x3, x3, x1
+    addi x2, x2, -1
+    bne x2, x0, loop
+    halt
+)";
+
+void checkFinalState(const PipelinedSimulator &simulator) {
+    for (int c = 0; c < simulator.getNumCores(); c++) {
+        const PipelinedCore &core = simulator.getCore(c);
+        CHECK_EQ(core.getRegister(1), 2);
+        CHECK_EQ(core.getRegister(2), 0);
+        CHECK_EQ(core.getRegister(3), 6);
+    }
+}
+
+} // namespace
+
+int main() {
+    SimLog::setLevel(LogLevel::OFF);
+    for (bool forwarding: {true, false}) {
+        for (uint64_t budget: {0, 1, 2, 3, 4, 5, 6, 8, 11}) {
+            std::cerr << "forwarding " << forwarding << ", fast-forward " << budget << "\n";
+            PipelinedSimulator simulator(4, forwarding);
+            simulator.setTracePrefix("");
+            simulator.loadProgram(PROGRAM);
+            if (budget > 0) {
+                FastForwardOptions options;
+                options.maxInstructions = budget;
+                simulator.fastForward(options);
+            }
+            simulator.simulate();
+            checkFinalState(simulator);
+        }
+    }
+    return testResult();
+}
@@ -0,0 +1,50 @@
+// Cycle and stall counts of the original sample programs, with forwarding on
+// and off, against the simulator as it was before the register scoreboard
+// (user-007) and every later change. Runs from the Phase_3 directory, so the
+// hierarchy reads cache_config.txt.
+#include "pipelined_simulator.hpp"
+#include "sim_log.hpp"
+#include "test_support.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Expected {
+    const char *program;
+    bool forwarding;
+    std::vector<int> cycles;  // per core
+    uint64_t stalls;
+    uint64_t memoryStalls;
+};
+
+const Expected BASELINE[] = {
+    {"algo1.txt", true, {332, 332, 332, 332}, 640, 620},
+    {"algo1.txt", false, {429, 429, 429, 429}, 1628, 620},
+    {"algo2.txt", true, {368, 368, 368, 368}, 640, 620},
+    {"algo2.txt", false, {485, 485, 485, 485}, 1708, 620},
+    {"array_sum.txt", true, {434, 458, 434, 433}, 332, 321},
+    {"array_sum.txt", false, {489, 527, 489, 488}, 876, 321},
+    {"bubble_sort.txt", true, {229, 229, 229, 229}, 48, 44},
+    {"bubble_sort.txt", false, {386, 386, 386, 386}, 708, 44},
+    {"test.txt", true, {18, 18, 18, 18}, 44, 44},
+    {"test.txt", false, {19, 19, 19, 19}, 48, 44},
+};
+
+} // namespace
+
+int main() {
+    SimLog::setLevel(LogLevel::OFF);
+    for (const Expected &expected: BASELINE) {
+        PipelinedSimulator simulator(4, expected.forwarding);
+        simulator.setTracePrefix("");
+        simulator.loadProgramFromFile(expected.program);
+        simulator.simulate();
+
+        std::cerr << expected.program << (expected.forwarding ? " with" : " without") << " forwarding\n";
+        CHECK(simulator.getCycleCounts() == expected.cycles);
+        CHECK_EQ(simulator.getTotalStalls(), expected.stalls);
+        CHECK_EQ(simulator.getTotalMemoryStalls(), expected.memoryStalls);
+    }
+    return testResult();
+}
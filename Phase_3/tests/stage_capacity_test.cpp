@@ -0,0 +1,45 @@
+// Stage capacities other than Pipeline::DEFAULT_STAGE_CAPACITY give wrong
+// results (see Pipeline::checkStageCapacity), so every setter rejects them
+// and leaves the configured capacity alone.
+#include "pipelined_simulator.hpp"
+#include "sim_log.hpp"
+#include "test_support.hpp"
+#include <stdexcept>
+
+namespace {
+
+template <typename Setter>
+bool rejects(Setter set, int capacity) {
+    try {
+        set(capacity);
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main() {
+    SimLog::setLevel(LogLevel::OFF);
+    PipelinedSimulator simulator(4);
+    PipelinedCore core(0);
+    Pipeline pipeline;
+    for (int capacity: {-1, 0, 1, 3, 4, 8}) {
+        std::cerr << "capacity " << capacity << "\n";
+        CHECK(rejects([&](int c) { simulator.setStageCapacity(c); }, capacity));
+        CHECK(rejects([&](int c) { core.setStageCapacity(c); }, capacity));
+        CHECK(rejects([&](int c) { pipeline.setStageCapacity(c); }, capacity));
+    }
+    CHECK_EQ(simulator.getStageCapacity(), Pipeline::DEFAULT_STAGE_CAPACITY);
+    CHECK_EQ(core.getStageCapacity(), Pipeline::DEFAULT_STAGE_CAPACITY);
+    CHECK_EQ(pipeline.getStageCapacity(), Pipeline::DEFAULT_STAGE_CAPACITY);
+
+    // The default is still accepted, and the simulator runs with it
+    simulator.setStageCapacity(Pipeline::DEFAULT_STAGE_CAPACITY);
+    simulator.setTracePrefix("");
+    simulator.loadProgramFromFile("test.txt");
+    simulator.simulate();
+    CHECK(simulator.getCycleCounts() == std::vector<int>({18, 18, 18, 18}));
+    return testResult();
+}
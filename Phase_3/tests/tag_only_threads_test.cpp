@@ -0,0 +1,105 @@
+// With quantum 1, running the cores on several host threads must give the
+// serial results exactly, in tag-only mode too: there every load reads main
+// memory, so even an L1D hit has to take the shared-access turn. The sample
+// programs and one where three cores read a word the fourth keeps storing run
+// tag-only on 1 and 4 host threads; cycles, stalls, registers and L1D/L2
+// statistics must match. Runs from the Phase_3 directory.
+#include "cache_config.hpp"
+#include "pipelined_simulator.hpp"
+#include "sim_log.hpp"
+#include "test_support.hpp"
+#include <fstream>
+
+namespace {
+
+// Core 0 counts word 0 down from 300 while cores 1-3 sum what they read of it.
+// The readers hit in their L1D, so the sums depend on the order of the loads
+// and stores within each cycle.
+const char *SHARED_WORD = R"(
+.text
+    beq x31,0,writer
+    addi x2, x0, 300
+read:
+    lw x3, 0(x0)
+    add x5, x5, x3
+    addi x2, x2, -1
+    bne x2, x0, read
+    halt
+writer:
+    addi x2, x0, 300
+write:
+    sw x2, 0(x0)
+    addi x2, x2, -1
+    bne x2, x0, write
+    halt
+)";
+
+struct Result {
+    std::vector<int> cycles;
+    uint64_t stalls;
+    uint64_t memoryStalls;
+    std::vector<std::vector<int>> registers;
+    uint64_t l1dHits;
+    uint64_t l2Hits;
+};
+
+// program is a file name, or the source itself when isSource is set
+Result run(const char *program, int hostThreads, bool isSource = false) {
+    CacheConfig config;
+    std::ifstream file("cache_config.txt");
+    config.read(file);
+    config.tagOnly = true;
+
+    PipelinedSimulator simulator(4);
+    simulator.setTracePrefix("");
+    simulator.setCacheConfig(config);
+    simulator.setHostThreads(hostThreads);
+    if (isSource) {
+        simulator.loadProgram(program);
+    } else {
+        simulator.loadProgramFromFile(program);
+    }
+    simulator.simulate();
+
+    Result result{simulator.getCycleCounts(), simulator.getTotalStalls(), simulator.getTotalMemoryStalls(), {},
+                  simulator.cacheTotals(MemoryHierarchy::CacheType::L1D).hits,
+                  simulator.cacheTotals(MemoryHierarchy::CacheType::L2).hits};
+    for (int c = 0; c < simulator.getNumCores(); c++) {
+        result.registers.push_back(simulator.getCore(c).getRegisters());
+    }
+    return result;
+}
+
+} // namespace
+
+int main() {
+    SimLog::setLevel(LogLevel::OFF);
+    struct Program {
+        const char *name;
+        const char *text;
+        bool isSource;
+    };
+    const Program programs[] = {
+        {"algo1.txt", "algo1.txt", false},
+        {"algo2.txt", "algo2.txt", false},
+        {"array_sum.txt", "array_sum.txt", false},
+        {"bubble_sort.txt", "bubble_sort.txt", false},
+        {"test.txt", "test.txt", false},
+        {"shared word", SHARED_WORD, true},
+    };
+    for (const Program &program: programs) {
+        Result serial = run(program.text, 1, program.isSource);
+        // Races show up only sometimes, so each threaded run is repeated
+        for (int repeat = 0; repeat < 20; repeat++) {
+            Result threaded = run(program.text, 4, program.isSource);
+            std::cerr << program.name << ", run " << repeat << "\n";
+            CHECK(threaded.cycles == serial.cycles);
+            CHECK_EQ(threaded.stalls, serial.stalls);
+            CHECK_EQ(threaded.memoryStalls, serial.memoryStalls);
+            CHECK(threaded.registers == serial.registers);
+            CHECK_EQ(threaded.l1dHits, serial.l1dHits);
+            CHECK_EQ(threaded.l2Hits, serial.l2Hits);
+        }
+    }
+    return testResult();
+}
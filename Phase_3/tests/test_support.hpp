@@ -0,0 +1,38 @@
+#ifndef TEST_SUPPORT_HPP
+#define TEST_SUPPORT_HPP
+
+#include <iostream>
+
+// Checks for the ctest executables in this directory. A failed check prints
+// its location and the test keeps going; main returns testResult(), which is
+// nonzero once any check has failed.
+inline int testFailures = 0;
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+            testFailures++;                                                                \
+        }                                                                                  \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                         \
+    do {                                                                                   \
+        auto actualValue = (actual);                                                       \
+        auto expectedValue = (expected);                                                   \
+        if (!(actualValue == expectedValue)) {                                             \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " #actual " is " << actualValue  \
+                      << ", expected " << expectedValue << "\n";                           \
+            testFailures++;                                                                \
+        }                                                                                  \
+    } while (0)
+
+inline int testResult() {
+    if (testFailures > 0) {
+        std::cerr << testFailures << " check(s) failed\n";
+        return 1;
+    }
+    return 0;
+}
+
+#endif // TEST_SUPPORT_HPP
@@ -0,0 +1,27 @@
+#include "pipeline_trace.hpp"
+#include <iostream>
+#include <string>
+
+// Offline converter: pipeline_coreN.trace -> pipeline_coreN.csv, optionally
+// restricted to a window of cycles so long runs stay readable.
+int main(int argc, char **argv) {
+    if (argc != 3 && argc != 5) {
+        std::cerr << "Usage: " << argv[0] << " <trace file> <csv file> [first cycle] [last cycle]\n"
+                  << "Cycles are 1-based and inclusive, matching the CycleN columns.\n";
+        return 1;
+    }
+
+    try {
+        if (argc == 5) {
+            PipelineTraceConverter::toCsv(argv[1], argv[2], std::stoi(argv[3]), std::stoi(argv[4]));
+        } else {
+            PipelineTraceConverter::toCsv(argv[1], argv[2]);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "Wrote " << argv[2] << "\n";
+    return 0;
+}
@@ -0,0 +1,111 @@
+#ifndef WORK_STEALING_POOL_HPP
+#define WORK_STEALING_POOL_HPP
+
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Runs task(i) for every i in [0, count) on a fixed number of host threads.
+// Each thread starts with its own contiguous share of the indices and works
+// through it from the front; a thread that runs dry steals from the back of
+// another thread's share, so a few long tasks do not leave the rest of the
+// pool idle. Tasks are independent: nothing is spawned while running.
+class WorkStealingPool {
+public:
+    // Throws std::invalid_argument for less than 1 thread
+    explicit WorkStealingPool(int threads) : threads(threads) {
+        if (threads < 1) {
+            throw std::invalid_argument("Thread pool needs at least 1 thread");
+        }
+    }
+
+    // Host CPUs, or 1 when the host does not say
+    static int hostThreads() {
+        return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+
+    int getThreadCount() const { return threads; }
+
+    // Blocks until every task has run; the calling thread is one of the
+    // workers. The first exception a task throws is rethrown here once the
+    // other tasks are done.
+    template <typename Task>
+    void run(size_t count, Task &&task) {
+        int workers = static_cast<int>(std::min<size_t>(threads, std::max<size_t>(count, 1)));
+        std::vector<std::unique_ptr<Queue>> queues;
+        for (int w = 0; w < workers; w++) {
+            queues.push_back(std::make_unique<Queue>());
+            for (size_t i = count * w / workers; i < count * (w + 1) / workers; i++) {
+                queues.back()->items.push_back(i);
+            }
+        }
+
+        std::mutex errorLock;
+        std::exception_ptr error;
+        auto work = [&](int self) {
+            size_t index;
+            while (take(queues, self, index)) {
+                try {
+                    task(index);
+                } catch (...) {
+                    std::lock_guard<std::mutex> guard(errorLock);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (int w = 1; w < workers; w++) {
+            pool.emplace_back(work, w);
+        }
+        work(0);
+        for (auto &thread: pool) {
+            thread.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<size_t> items;
+    };
+
+    int threads;
+
+    // Own queue first (front), then steal from the back of the others,
+    // starting with the next thread so thieves spread out
+    static bool take(std::vector<std::unique_ptr<Queue>> &queues, int self, size_t &index) {
+        {
+            Queue &own = *queues[self];
+            std::lock_guard<std::mutex> guard(own.lock);
+            if (!own.items.empty()) {
+                index = own.items.front();
+                own.items.pop_front();
+                return true;
+            }
+        }
+        int workers = static_cast<int>(queues.size());
+        for (int step = 1; step < workers; step++) {
+            Queue &victim = *queues[(self + step) % workers];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.items.empty()) {
+                index = victim.items.back();
+                victim.items.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif // WORK_STEALING_POOL_HPP